@@ -0,0 +1,441 @@
+#define TAPKI_IMPLEMENTATION
+#include "tapki.h"
+#include <time.h>
+
+#define BENCH(name) for (clock_t __start = clock(), __f = 0; !__f; \
+    fprintf(stderr, "%-40s %8.2f ms\n", name, (double)(clock() - __start) * 1000.0 / CLOCKS_PER_SEC), __f = 1)
+
+static uint64_t rng_state = 42;
+
+static uint64_t Rand() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static volatile size_t sink;
+
+MapDeclare(IntMap, uint64_t, uint64_t);
+MapImplement(IntMap, TRIVIAL_LESS, TRIVIAL_EQ);
+
+// Keys sharing long prefix stress strcmp(); unique prefix is best case for TapkiStrKey
+static void Bench_StrMaps(Arena* arena, const char* layout) {
+    enum { N = 200000, LOOKUPS = 2000000 };
+    fprintf(stderr, "keys \"%s\":\n", layout);
+    char** keys = (char**)ArenaAlloc(arena, sizeof(char*) * N);
+    for (size_t i = 0; i < N; ++i) {
+        keys[i] = F(layout, (unsigned long long)Rand()).d;
+    }
+    StrMap map = {0};
+    BENCH("StrMap: BuildFrom + Finalize") {
+        TapkiStrMap_Pair* pairs = (TapkiStrMap_Pair*)ArenaAlloc(arena, sizeof(TapkiStrMap_Pair) * N);
+        for (size_t i = 0; i < N; ++i) {
+            memcpy(&pairs[i], &(TapkiStrMap_Pair){keys[i]}, sizeof(TapkiStrMap_Pair));
+        }
+        StrMap_BuildFrom(&map, pairs, N);
+        StrMap_Finalize(&map);
+    }
+    BENCH("StrMap: Find (binary search)") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += StrMap_Find(&map, keys[Rand() % N]) != NULL;
+        }
+    }
+    StrKeyMap kmap = {0};
+    TapkiStrKey* skeys = (TapkiStrKey*)ArenaAlloc(arena, sizeof(TapkiStrKey) * N);
+    for (size_t i = 0; i < N; ++i) {
+        skeys[i] = StrKey(keys[i]);
+        memcpy(VecPush(&kmap), &(TapkiStrKeyMap_Pair){skeys[i]}, sizeof(TapkiStrKeyMap_Pair));
+    }
+    TapkiStrKeyMap_Finalize(arena, &kmap);
+    BENCH("StrKeyMap: Find (binary search)") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += StrKeyMap_Find(&kmap, skeys[Rand() % N]) != NULL;
+        }
+    }
+    StrKeyMap_Freeze(&kmap);
+    BENCH("StrKeyMap: Find (frozen)") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += StrKeyMap_Find(&kmap, skeys[Rand() % N]) != NULL;
+        }
+    }
+    StrHashMap hmap = {0};
+    BENCH("StrHashMap: At") {
+        for (size_t i = 0; i < N; ++i) {
+            StrHashMap_At(&hmap, keys[i]);
+        }
+    }
+    BENCH("StrHashMap: Find") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += StrHashMap_Find(&hmap, keys[Rand() % N]) != NULL;
+        }
+    }
+}
+
+void Bench_Maps(Arena* arena) {
+    enum { N = 200000, LOOKUPS = 2000000 };
+    Bench_StrMaps(arena, "symbol_%016llx");
+    Bench_StrMaps(arena, "%016llx.symbol");
+    IntMap imap = {0};
+    uint64_t* ikeys = (uint64_t*)ArenaAlloc(arena, sizeof(uint64_t) * N);
+    for (size_t i = 0; i < N; ++i) {
+        ikeys[i] = Rand();
+        memcpy(VecPush(&imap), &(IntMap_Pair){ikeys[i], i}, sizeof(IntMap_Pair));
+    }
+    IntMap_Finalize(arena, &imap);
+    BENCH("IntMap: Find (binary search)") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += IntMap_Find(&imap, ikeys[Rand() % N]) != NULL;
+        }
+    }
+    IntMap_Freeze(arena, &imap);
+    BENCH("IntMap: Find (frozen)") {
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            sink += IntMap_Find(&imap, ikeys[Rand() % N]) != NULL;
+        }
+    }
+}
+
+void Bench_Strings() {
+    enum { N = 1000000 };
+    Arena* arena = ArenaCreate(64 * 1024);
+    StrVec strs = {0};
+    BENCH("Str: 1M short copies") {
+        for (size_t i = 0; i < N; ++i) {
+            *VecPush(&strs) = F("v%zu", i & 0xffff);
+        }
+    }
+    fprintf(stderr, "  in use: %zu KiB\n", ArenaStats(arena).in_use / 1024);
+    ArenaClear(arena);
+    Vec(SStr) sstrs = {0};
+    BENCH("SStr: 1M short copies") {
+        for (size_t i = 0; i < N; ++i) {
+            SStr* s = VecPush(&sstrs);
+            SStrAppendF(s, "v%zu", i & 0xffff);
+        }
+    }
+    fprintf(stderr, "  in use: %zu KiB\n", ArenaStats(arena).in_use / 1024);
+    ArenaFree(arena);
+}
+
+void Bench_Split() {
+    enum { N = 50000 };
+    Arena* arena = ArenaCreate(1024 * 1024);
+    Str csv = {0};
+    for (size_t i = 0; i < N; ++i) {
+        StrAppend(&csv, "field,");
+    }
+    BENCH("StrSplit: 50k fields") {
+        sink += StrSplit(csv.d, ",").size;
+    }
+    BENCH("SV_Split: 50k fields") {
+        sink += SV_Split(SV(csv), SVOf(",")).size;
+    }
+    BENCH("SV_SplitViews: 50k fields") {
+        sink += SV_SplitViews(SV(csv), SVOf(",")).size;
+    }
+    BENCH("StrSplitNext: 50k fields") {
+        StrView rest = SV(csv), tok;
+        while (StrSplitNext(&rest, SVOf(","), &tok)) {
+            sink += tok.size;
+        }
+    }
+    ArenaFree(arena);
+}
+
+void Bench_Search() {
+    enum { N = 1 << 20, LOOPS = 200 };
+    Arena* arena = ArenaCreate(1024 * 1024);
+    Str text = {0};
+    while (text.size < N) {
+        StrAppend(&text, "lorem ipsum dolor sit amet, consectetur adipiscing elit / ");
+    }
+    StrAppend(&text, "needle in haystack");
+    BENCH("StrFind: 1 MiB, needle at end") {
+        for (size_t i = 0; i < LOOPS; ++i) {
+            sink += StrFind(text.d, "needle in", 0);
+        }
+    }
+    BENCH("StrRevFind: 1 MiB, '/' near end") {
+        for (size_t i = 0; i < LOOPS; ++i) {
+            sink += StrRevFind(text.d, "/");
+        }
+    }
+    BENCH("StrRevFind: 1 MiB, needle at start") {
+        for (size_t i = 0; i < 5; ++i) {
+            sink += StrRevFind(text.d, "lorem ipsum dolor sit amet, consectetur adipiscing elit / lorem");
+        }
+    }
+    const char* keywords[128];
+    for (size_t i = 0; i < 128; ++i) {
+        keywords[i] = F("%s%zu", i & 1 ? "error" : "warning", i).d;
+    }
+    BENCH("StrContains: 128 keywords x 1 MiB") {
+        for (size_t i = 0; i < 128; ++i) {
+            sink += StrContains(text.d, keywords[i]);
+        }
+    }
+    Matcher* m = MatcherCreate(keywords, 128);
+    BENCH("Matcher: 128 keywords x 1 MiB") {
+        sink += MatcherFindAll(m, SV(text)).size;
+    }
+    ArenaFree(arena);
+}
+
+void Bench_Format() {
+    enum { N = 1000000 };
+    Arena* arena = ArenaCreate(1024 * 1024);
+    const char* longField = "................................................................................"
+                            "................................................................................"
+                            "................................................................................";
+    BENCH("StrAppendF: 1M long lines") {
+        Str out = {0};
+        for (size_t i = 0; i < N; ++i) {
+            StrAppendF(&out, "%zu: %s\n", i, longField);
+        }
+        sink += out.size;
+    }
+    ArenaClear(arena);
+    BENCH("StrAppendF: 1M \"%s%d\"") {
+        Str out = {0};
+        for (int i = 0; i < N; ++i) {
+            StrAppendF(&out, "%s%d", "key", i);
+        }
+        sink += out.size;
+    }
+    ArenaClear(arena);
+    BENCH("F: 1M \"%s=%d\" strings") {
+        for (int i = 0; i < N; ++i) {
+            sink += F("%s=%d", "key", i).size;
+        }
+    }
+    ArenaFree(arena);
+}
+
+void Bench_Parse() {
+    enum { N = 5000000 };
+    Arena* arena = ArenaCreate(1024 * 1024);
+    Str csv = {0}, floats = {0};
+    for (size_t i = 0; i < N; ++i) {
+        StrAppendI64(&csv, (int64_t)(Rand() >> (Rand() & 63)) * (i & 1 ? -1 : 1));
+        StrAppend(&csv, "\n");
+        StrAppendF(&floats, "%.*f\n", (int)(i % 7), (double)(Rand() % 100000000) / 1000);
+    }
+    BENCH("strtoll: 5M ints") {
+        char* it = csv.d;
+        while (*it) {
+            sink += (size_t)strtoll(it, &it, 10);
+            it++;
+        }
+    }
+    BENCH("ParseI64Bulk: 5M ints") {
+        IntVec out = {0};
+        ParseI64Bulk(SV(csv), '\n', &out, NULL);
+        sink += out.size;
+    }
+    BENCH("strtod: 5M doubles") {
+        char* it = floats.d;
+        while (*it) {
+            sink += (size_t)strtod(it, &it);
+            it++;
+        }
+    }
+    BENCH("ParseDouble: 5M doubles") {
+        StrView rest = SV(floats), tok;
+        double d;
+        while (StrSplitNext(&rest, SVOf("\n"), &tok)) {
+            sink += ParseDouble(tok, &d) == TAPKI_PARSE_OK ? (size_t)d : 0;
+        }
+    }
+    ArenaFree(arena);
+}
+
+void Bench_Files() {
+    enum { N = 4000000 };
+    Arena* arena = ArenaCreate(1024 * 1024);
+    const char* path = "tapki_bench_file.tmp";
+    Str contents = {0};
+    for (size_t i = 0; i < N; ++i) {
+        StrAppendF(&contents, "%zu,%llu\n", i, (unsigned long long)Rand());
+    }
+    FileWrite(path, contents.d);
+    ArenaClear(arena);
+    BENCH("FileRead: ~100 MiB + count lines") {
+        Str data = FileRead(path);
+        for (const char* it = data.d; (it = memchr(it, '\n', data.d + data.size - it)); ++it) {
+            sink++;
+        }
+    }
+    fprintf(stderr, "  heap: %zu KiB\n", ArenaStats(arena).large / 1024);
+    ArenaClear(arena);
+    BENCH("FileMap: ~100 MiB + count lines") {
+        StrView data = FileMap(path, TAPKI_MAP_SEQUENTIAL);
+        for (const char* it = data.d; (it = memchr(it, '\n', data.d + data.size - it)); ++it) {
+            sink++;
+        }
+    }
+    fprintf(stderr, "  heap: %zu KiB, mapped: %zu KiB\n", ArenaStats(arena).large / 1024, ArenaStats(arena).mapped / 1024);
+    ArenaClear(arena);
+    BENCH("Reader: ~100 MiB, NextLine") {
+        Reader* r = ReaderOpen(path);
+        StrView line;
+        while (ReaderNextLine(r, &line)) {
+            sink++;
+        }
+    }
+    fprintf(stderr, "  heap: %zu KiB\n", ArenaStats(arena).large / 1024);
+    BENCH("fgets: ~100 MiB") {
+        FILE* f = fopen(path, "rb");
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            sink++;
+        }
+        fclose(f);
+    }
+    remove(path);
+    ArenaClear(arena);
+    enum { FILES = 20000 };
+    const char** paths = (const char**)ArenaAlloc(arena, sizeof(char*) * FILES);
+    for (size_t i = 0; i < FILES; ++i) {
+        paths[i] = F("tapki_bench_%zu.tmp", i).d;
+        FileWrite(paths[i], F("%0*zu", (int)(Rand() % 4096), i).d);
+    }
+    BENCH("FileRead: 20k small files") {
+        for (size_t i = 0; i < FILES; ++i) {
+            sink += FileRead(paths[i]).size;
+        }
+    }
+    BENCH("FileReadMany: 20k small files") {
+        StrVec all = FileReadMany(paths, FILES);
+        for (size_t i = 0; i < FILES; ++i) {
+            sink += all.d[i].size;
+        }
+    }
+    for (size_t i = 0; i < FILES; ++i) {
+        remove(paths[i]);
+    }
+    enum { LINES = 100000 };
+    Str line = S("2024-01-01 12:00:00 INFO request served in 12 ms\n");
+    BENCH("FileAppend: 100k log lines") {
+        for (size_t i = 0; i < LINES; ++i) {
+            FileAppend(path, line.d);
+        }
+    }
+    BENCH("Writer: 100k log lines") {
+        Writer* w = WriterOpen(path, TAPKI_WRITE_TRUNCATE);
+        for (size_t i = 0; i < LINES; ++i) {
+            WriterAppend(w, line.d, line.size);
+        }
+        WriterClose(w);
+    }
+    remove(path);
+    ArenaFree(arena);
+}
+
+void Bench_Frames() {
+    enum { N = 10000000 };
+    const char* name = "items";
+    BENCH("FrameF: 10M \"item %d of %s\"") {
+        for (int i = 0; i < N; ++i) {
+            FrameF("item %d of %s", i, name) {
+                sink++;
+            }
+        }
+    }
+    BENCH("Frame: 10M") {
+        for (int i = 0; i < N; ++i) {
+            Frame() {
+                sink++;
+            }
+        }
+    }
+    ProfilerStart(1000);
+    BENCH("Frame: 10M, profiler at 1 kHz") {
+        for (int i = 0; i < N; ++i) {
+            Frame() {
+                sink++;
+            }
+        }
+    }
+    ProfilerStop();
+    FrameTimingStart(false);
+    BENCH("Frame: 10M, timing on") {
+        for (int i = 0; i < N; ++i) {
+            Frame() {
+                sink++;
+            }
+        }
+    }
+    FrameTimingStart(true);
+    BENCH("Frame: 1M, timing + trace on") {
+        for (int i = 0; i < N / 10; ++i) {
+            Frame() {
+                sink++;
+            }
+        }
+    }
+    FrameTimingStop();
+    FrameTimingReset();
+}
+
+void Bench_Arenas() {
+    enum { N = 1000000 };
+    BENCH("Arena: Create(1024) + Alloc + Free") {
+        for (size_t i = 0; i < N; ++i) {
+            Arena* arena = ArenaCreate(1024);
+            sink += S("temporary").size;
+            ArenaFree(arena);
+        }
+    }
+}
+
+void Bench_Vectors() {
+    enum { N = 4000000 };
+    Arena* arena = ArenaCreate(64 * 1024);
+    IntVec a = {0}, b = {0};
+    BENCH("Vec: 2 interleaved IntVec pushes") {
+        for (int64_t i = 0; i < N; ++i) {
+            *VecPush(&a) = i;
+            *VecPush(&b) = i;
+        }
+    }
+    ArenaStats stats = ArenaStats(arena);
+    fprintf(stderr, "  reserved: %zu KiB, large: %zu KiB, wasted by relocations: %zu KiB\n", stats.reserved / 1024, stats.large / 1024, stats.wasted_vec / 1024);
+    ArenaFree(arena);
+}
+
+int main() {
+    Arena* arena = ArenaCreate(1024 * 1024);
+    FrameF("Maps") {
+        Bench_Maps(arena);
+    }
+    FrameF("Vectors") {
+        Bench_Vectors();
+    }
+    FrameF("Strings") {
+        Bench_Strings();
+    }
+    FrameF("Split") {
+        Bench_Split();
+    }
+    FrameF("Search") {
+        Bench_Search();
+    }
+    FrameF("Format") {
+        Bench_Format();
+    }
+    FrameF("Parse") {
+        Bench_Parse();
+    }
+    FrameF("Files") {
+        Bench_Files();
+    }
+    FrameF("Frames") {
+        Bench_Frames();
+    }
+    FrameF("Arenas") {
+        Bench_Arenas();
+    }
+    ArenaFree(arena);
+    return 0;
+}
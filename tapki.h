@@ -14,9 +14,67 @@
 extern "C" {
 #endif
 
+// POSIX builds use pthreads (thread exit hook of arena cache, TapkiFileReadMany() workers):
+// with glibc older than 2.34 link with -pthread
+
 // Define this to disable TTY detection
 // #undef TAPKI_CLI_NO_TTY
 
+// Default limit for geometric chunk growth of arenas
+#ifndef TAPKI_ARENA_MAX_CHUNK_SIZE
+#define TAPKI_ARENA_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+#endif
+
+// Vectors growing past this size move to dedicated blocks, grown in place with realloc().
+// Unlike arena memory, their old buffer does not stay valid: copies of such vector (or pointers
+// into it) dangle once it grows. Appending a vector's own contents to it is handled.
+#ifndef TAPKI_ARENA_LARGE_VEC
+#define TAPKI_ARENA_LARGE_VEC (64 * 1024)
+#endif
+
+// Define this to allocate big arena chunks (>= TAPKI_ARENA_MMAP_MIN) with mmap (+ huge pages hint)
+// #define TAPKI_ARENA_MMAP
+
+// Initial buffer size of streaming readers (grows for longer records)
+#ifndef TAPKI_READER_BUFFER
+#define TAPKI_READER_BUFFER (256 * 1024)
+#endif
+
+// Buffer size of TapkiWriter (bigger appends are written directly)
+#ifndef TAPKI_WRITER_BUFFER
+#define TAPKI_WRITER_BUFFER (64 * 1024)
+#endif
+
+// Define this to make TapkiFileReadMany() use threads even where io_uring is available
+// #define TAPKI_NO_IO_URING
+
+// Files read concurrently by TapkiFileReadMany() (io_uring queue depth / worker threads)
+#ifndef TAPKI_READ_MANY_DEPTH
+#define TAPKI_READ_MANY_DEPTH 64
+#endif
+#ifndef TAPKI_READ_MANY_THREADS
+#define TAPKI_READ_MANY_THREADS 16
+#endif
+
+// Capacity of sampling profiler: distinct stacks (power of two), frames stored for them, max depth of one sample
+#ifndef TAPKI_PROFILER_STACKS
+#define TAPKI_PROFILER_STACKS 4096
+#endif
+#ifndef TAPKI_PROFILER_FRAMES
+#define TAPKI_PROFILER_FRAMES (64 * 1024)
+#endif
+#ifndef TAPKI_PROFILER_DEPTH
+#define TAPKI_PROFILER_DEPTH 64
+#endif
+
+// Max scopes recorded per thread for trace export of frame timing
+#ifndef TAPKI_TRACE_EVENTS
+#define TAPKI_TRACE_EVENTS (1024 * 1024)
+#endif
+
+// Define this to disable SSE2/AVX2 reverse substring search kernels (scalar fallback is always available)
+// #define TAPKI_NO_SIMD
+
 
 // If TAPKI_FULL_NAMESPACE is not defined -> you can use Public API without Tapki* prefix
 
@@ -24,10 +82,23 @@ extern "C" {
 #ifndef TAPKI_FULL_NAMESPACE
 
 // typedef TapkiArena Arena;
+// typedef TapkiArenaPos ArenaPos;
+// typedef TapkiArenaStats ArenaStats;
 // typedef TapkiStr Str;
 // typedef TapkiStrMap StrMap;
+// typedef TapkiStrHashMap StrHashMap;
+// typedef TapkiStrKeyMap StrKeyMap;
 // typedef TapkiStrVec StrVec;
+// typedef TapkiSStr SStr;
+// typedef TapkiStrView StrView;
+// typedef TapkiStrViewVec StrViewVec;
+// typedef TapkiSStrMap SStrMap;
 // typedef TapkiIntVec IntVec;
+// typedef TapkiMatcher Matcher;
+// typedef TapkiMatch Match;
+// typedef TapkiMatchVec MatchVec;
+// typedef TapkiReader Reader;
+// typedef TapkiWriter Writer;
 // typedef TapkiCLI CLI;
 
 #define Vec(type)                       TapkiVec(type)
@@ -44,10 +115,19 @@ extern "C" {
 #define VecResize(vec, n)               TapkiVecResize(arena, vec, n)
 
 #define ArenaCreate(chunksize)          TapkiArenaCreate(chunksize)
+#define ArenaCreateEx(chunksize, max)   TapkiArenaCreateEx(chunksize, max)
 #define ArenaAllocAligned(ar, sz, al)   TapkiArenaAllocAligned(ar, sz, al)
 #define ArenaAlloc(arena, sz)           TapkiArenaAlloc(arena, sz)
+#define ArenaAllocUninit(ar, sz, al)    TapkiArenaAllocUninit(ar, sz, al)
 #define ArenaClear(arena)               TapkiArenaClear(arena)
 #define ArenaFree(arena)                TapkiArenaFree(arena)
+#define ArenaMark(arena)                TapkiArenaMark(arena)
+#define ArenaRestore(arena, pos)        TapkiArenaRestore(arena, pos)
+#define ArenaScope(arena)               TapkiArenaScope(arena)
+#define ArenaTrim()                     TapkiArenaTrim()
+#define ArenaStats(arena)               TapkiArenaGetStats(arena)
+#define ArenaCreateShared(chunksize)    TapkiArenaCreateShared(chunksize)
+#define ArenaAttach(shared)             TapkiArenaAttach(shared)
 
 #define F(...)                          TapkiF(arena, __VA_ARGS__)
 #define S(str)                          TapkiS(arena, str)
@@ -58,9 +138,20 @@ extern "C" {
 #define ToU64(str)                      TapkiToU64(str)
 #define ToFloat(str)                    TapkiToFloat(str)
 
+#define ParseI32(s, out)                TapkiParseI32(s, out)
+#define ParseU32(s, out)                TapkiParseU32(s, out)
+#define ParseI64(s, out)                TapkiParseI64(s, out)
+#define ParseU64(s, out)                TapkiParseU64(s, out)
+#define ParseDouble(s, out)             TapkiParseDouble(s, out)
+#define ParseI64Bulk(s, delim, out, bad) TapkiParseI64Bulk(arena, s, delim, out, bad)
+#define ParseErrStr(err)                TapkiParseErrStr(err)
+
     
 #define StrAppend(s, ...)               TapkiStrAppend(arena, s, __VA_ARGS__)
 #define StrAppendF(s, ...)              TapkiStrAppendF(arena, s, __VA_ARGS__)
+#define StrAppendI64(s, v)              TapkiStrAppendI64(arena, s, v)
+#define StrAppendU64(s, v)              TapkiStrAppendU64(arena, s, v)
+#define StrAppendDouble(s, v)           TapkiStrAppendDouble(arena, s, v)
 #define StrSplit(s, delim)              TapkiStrSplit(arena, s, delim)
 #define StrSub(s, from, to)             TapkiStrSub(arena, s, from, to)
 #define StrFind(s, needle, offs)        TapkiStrFind(s, needle, offs)
@@ -71,9 +162,43 @@ extern "C" {
 #define StrEndsWith(s, needle)          TapkiStrEndsWith(s, needle)
 #define npos                            Tapki_npos
 
+#define SV(str)                         TapkiSV(str)
+#define SVOf(chars)                     TapkiSV_Of(chars)
+#define SV_Sub(s, from, to)             TapkiSV_Sub(s, from, to)
+#define SV_Find(s, needle, offs)        TapkiSV_Find(s, needle, offs)
+#define SV_RevFind(s, needle)           TapkiSV_RevFind(s, needle)
+#define SV_Contains(s, needle)          TapkiSV_Contains(s, needle)
+#define SV_StartsWith(s, needle)        TapkiSV_StartsWith(s, needle)
+#define SV_EndsWith(s, needle)          TapkiSV_EndsWith(s, needle)
+#define SV_Eq(l, r)                     TapkiSV_Eq(l, r)
+#define SV_Copy(s)                      TapkiSV_Copy(arena, s)
+#define SV_Split(s, delim)              TapkiSV_Split(arena, s, delim)
+#define SV_SplitViews(s, delim)         TapkiSV_SplitViews(arena, s, delim)
+#define StrSplitViews(s, delim)         TapkiStrSplitViews(arena, s, delim)
+#define StrSplitNext(rest, delim, tok)  TapkiStrSplitNext(rest, delim, tok)
+#define StrAppendSV(s, view)            TapkiStrAppendSV(arena, s, view)
+
+#define MatcherCreate(needles, n)       TapkiMatcherCreate(arena, needles, n)
+#define MatcherFind(m, s, offs, needle) TapkiMatcherFind(m, s, offs, needle)
+#define MatcherFindAll(m, s)            TapkiMatcherFindAll(arena, m, s)
+
+#define SS(str)                         TapkiSS(arena, str)
+#define SStrCopy(chars, len)            TapkiSStrCopy(arena, chars, len)
+#define SStrAppend(s, ...)              TapkiSStrAppend(arena, s, __VA_ARGS__)
+#define SStrAppendF(s, ...)             TapkiSStrAppendF(arena, s, __VA_ARGS__)
+#define SStrData(s)                     TapkiSStrData(s)
+#define SStrSize(s)                     TapkiSStrSize(s)
+#define SStrFind(s, needle, offs)       TapkiSStrFind(s, needle, offs)
+#define SStrMap_At(map, key)            TapkiSStrMap_At(arena, map, key)
+#define SStrMap_Find(map, key)          TapkiSStrMap_Find(map, key)
+#define SStrMap_Erase(map, key)         TapkiSStrMap_Erase(map, key)
+
 #define StrMap_At(map, key)             TapkiStrMap_At(arena, map, key)
 #define StrMap_Find(map, key)           TapkiStrMap_Find(map, key)
 #define StrMap_Erase(map, key)          TapkiStrMap_Erase(map, key)
+#define StrMap_BuildFrom(map, pairs, n) TapkiStrMap_BuildFrom(arena, map, pairs, n)
+#define StrMap_Finalize(map)            TapkiStrMap_Finalize(arena, map)
+#define StrMap_Freeze(map)              TapkiStrMap_Freeze(arena, map)
 
 #define MapDeclare(map, key, value)     TapkiMapDeclare(map, key, value)
 #define MapImplement(map, less, eq)     TapkiMapImplement(map, less, eq)
@@ -82,6 +207,25 @@ extern "C" {
 #define STRING_LESS                     TAPKI_STRING_LESS
 #define STRING_EQ                       TAPKI_STRING_EQ
 
+#define StrKey(s)                       TapkiStrKeyOf(s)
+#define StrKeyMap_At(map, key)          TapkiStrKeyMap_At(arena, map, key)
+#define StrKeyMap_Find(map, key)        TapkiStrKeyMap_Find(map, key)
+#define StrKeyMap_Erase(map, key)       TapkiStrKeyMap_Erase(map, key)
+#define StrKeyMap_Freeze(map)           TapkiStrKeyMap_Freeze(arena, map)
+
+#define StrHashMap_At(map, key)         TapkiStrHashMap_At(arena, map, key)
+#define StrHashMap_Find(map, key)       TapkiStrHashMap_Find(map, key)
+#define StrHashMap_Erase(map, key)      TapkiStrHashMap_Erase(map, key)
+
+#define HashMapDeclare(map, key, value) TapkiHashMapDeclare(map, key, value)
+#define HashMapImplement(map, hash, eq) TapkiHashMapImplement(map, hash, eq)
+#define HashMapForEach(map, it)         TapkiHashMapForEach(map, it)
+#define TRIVIAL_HASH                    TAPKI_TRIVIAL_HASH
+#define STRING_HASH                     TAPKI_STRING_HASH
+#define STRKEY_LESS                     TAPKI_STRKEY_LESS
+#define STRKEY_EQ                       TAPKI_STRKEY_EQ
+#define STRKEY_HASH                     TAPKI_STRKEY_HASH
+
 #define SetDiePrefix(prefix)            TapkiSetDiePrefix(prefix)
 #define Die(...)                        TapkiDie(__VA_ARGS__)
 #define Assert(...)                     TapkiAssert(__VA_ARGS__)
@@ -89,6 +233,20 @@ extern "C" {
 #define FileWrite(file, data)           TapkiFileWrite(file, data)
 #define FileAppend(file, data)          TapkiFileAppend(file, data)
 #define FileRead(file)                  TapkiFileRead(arena, file)
+#define FileReadMany(paths, count)      TapkiFileReadMany(arena, paths, count)
+#define FileMap(file, advice)           TapkiFileMap(arena, file, advice)
+#define FileAdvise(view, advice)        TapkiFileAdvise(view, advice)
+#define ReaderOpen(path)                TapkiReaderOpen(arena, path)
+#define ReaderOpenFd(fd)                TapkiReaderOpenFd(arena, fd)
+#define ReaderNextLine(r, line)         TapkiReaderNextLine(r, line)
+#define ReaderNextRecord(r, delim, rec) TapkiReaderNextRecord(r, delim, rec)
+#define ReaderClose(r)                  TapkiReaderClose(r)
+#define WriterOpen(path, mode)          TapkiWriterOpen(arena, path, mode)
+#define WriterOpenFd(fd)                TapkiWriterOpenFd(arena, fd)
+#define WriterAppend(w, data, len)      TapkiWriterAppend(w, data, len)
+#define WriterAppendStrs(w, strs, n)    TapkiWriterAppendStrs(w, strs, n)
+#define WriterFlush(w)                  TapkiWriterFlush(w)
+#define WriterClose(w)                  TapkiWriterClose(w)
 
 #define PathJoin(...)                   TapkiPathJoin(arena, __VA_ARGS__)
 
@@ -98,6 +256,17 @@ extern "C" {
 #define Frame()                         TapkiFrame()
 #define Traceback()                     TapkiTraceback(arena)
 
+#define ProfilerStart(hz)               TapkiProfilerStart(hz)
+#define ProfilerStop()                  TapkiProfilerStop()
+#define ProfilerReset()                 TapkiProfilerReset()
+#define ProfilerFolded()                TapkiProfilerFolded(arena)
+
+#define FrameTimingStart(trace)         TapkiFrameTimingStart(trace)
+#define FrameTimingStop()               TapkiFrameTimingStop()
+#define FrameTimingReset()              TapkiFrameTimingReset()
+#define FrameReport()                   TapkiFrameReport(arena)
+#define FrameTraceJSON()                TapkiFrameTraceJSON(arena)
+
 #endif
 
 // Short API END
@@ -107,6 +276,7 @@ extern "C" {
     #define TAPKI_THREAD_LOCAL __thread
     #define TAPKI_NORETURN __attribute__((noreturn))
     #define TAPKI_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define TAPKI_PREFETCH(ptr) __builtin_prefetch(ptr)
     #define TAPKI_ALLOC_ATTR(sz, al) __attribute__((malloc, alloc_size(sz), alloc_align(al)))
     #define TAPKI_FMT_ATTR(fmt, args) __attribute__((format(printf, fmt, args)))
     #define TAPKI_RESTRICT __restrict__
@@ -116,16 +286,19 @@ extern "C" {
     #define TAPKI_THREAD_LOCAL __declspec(thread)
     #define TAPKI_NORETURN __declspec(noreturn)
     #define TAPKI_UNLIKELY(x) x
+    #define TAPKI_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
     #define TAPKI_ALLOC_ATTR(sz, al)
     #define TAPKI_FMT_ATTR(fmt, args)
     #define TAPKI_RESTRICT
     #define __tpk_strtok strtok_s
     #define __tpk_alloca _malloca
     #include <malloc.h>
+    #include <intrin.h>
 #else
     #define TAPKI_THREAD_LOCAL
     #define TAPKI_NORETURN
     #define TAPKI_UNLIKELY(x) x
+    #define TAPKI_PREFETCH(ptr) (void)(ptr)
     #define TAPKI_ALLOC_ATTR(sz, al)
     #define TAPKI_FMT_ATTR(fmt, args)
     #define TAPKI_RESTRICT
@@ -140,12 +313,59 @@ TAPKI_FMT_ATTR(1, 2) TAPKI_NORETURN void TapkiDie(const char* TAPKI_RESTRICT fmt
 // --- Arena
 typedef struct TapkiArena TapkiArena;
 
+// Each new chunk is twice as big as the previous one, up to maxChunkSize
+// (TapkiArenaCreate() uses TAPKI_ARENA_MAX_CHUNK_SIZE). Pass maxChunkSize == chunkSize to disable.
+TapkiArena* TapkiArenaCreateEx(size_t chunkSize, size_t maxChunkSize);
 TapkiArena* TapkiArenaCreate(size_t chunkSize);
 TAPKI_ALLOC_ATTR(2, 3) void* TapkiArenaAllocAligned(TapkiArena* arena, size_t size, size_t align);
+// Same as TapkiArenaAllocAligned(), but memory is not zeroed
+TAPKI_ALLOC_ATTR(2, 3) void* TapkiArenaAllocUninit(TapkiArena* arena, size_t size, size_t align);
 void* TapkiArenaAlloc(TapkiArena* arena, size_t size);
 char* TapkiArenaAllocChars(TapkiArena* arena, size_t count);
 void TapkiArenaClear(TapkiArena* arena);
 void TapkiArenaFree(TapkiArena* arena);
+// Freed chunks are kept in a per-thread cache (up to TAPKI_ARENA_CACHE_SIZE bytes) for reuse
+// by the next arenas. Call this to release the cache of the current thread early. Caches of
+// exiting threads are released automatically (POSIX: pthread key destructor).
+void TapkiArenaTrim(void);
+
+// Counters are always on (a few adds per allocation). Lifetime totals, unless noted.
+typedef struct TapkiArenaStats {
+    size_t allocated; // requested bytes (including in-place vector growth)
+    size_t wasted_align; // alignment padding
+    size_t wasted_tail; // chunk tails left behind when an allocation did not fit
+    size_t wasted_vec; // buffers abandoned by relocated vectors and rehashed maps
+    size_t in_use; // chunk space used now (since last Clear/Restore)
+    size_t high_water; // maximum of in_use
+    size_t chunks;
+    size_t largest_chunk;
+    size_t reserved; // total capacity of chunks
+    size_t large; // bytes in dedicated blocks of large vectors (see TAPKI_ARENA_LARGE_VEC)
+    size_t mapped; // bytes of files mapped with TapkiFileMap
+} TapkiArenaStats;
+
+TapkiArenaStats TapkiArenaGetStats(TapkiArena* arena);
+
+// Save-points: Restore() drops everything allocated after Mark() (positions taken later become invalid)
+typedef struct TapkiArenaPos {
+    void* chunk;
+    size_t ptr;
+    size_t in_use;
+    size_t large_seq;
+} TapkiArenaPos;
+
+TapkiArenaPos TapkiArenaMark(TapkiArena* arena);
+void TapkiArenaRestore(TapkiArena* arena, TapkiArenaPos pos);
+#define TapkiArenaScope(arena) for ( \
+    __tpk_arena_scope __ascope = { TapkiArenaMark(arena) }; \
+    !__ascope.__f; \
+    TapkiArenaRestore((arena), __ascope.pos), __ascope.__f = 1)
+
+// Shared arena: chunks are carved (lock-free) from common storage. Every thread must allocate
+// only through its own arena from TapkiArenaAttach() (the shared one belongs to its creator).
+// TapkiArenaFree() on the shared arena releases all attached arenas at once.
+TapkiArena* TapkiArenaCreateShared(size_t chunkSize);
+TapkiArena* TapkiArenaAttach(TapkiArena* shared);
 // ---
 
 // --- Vectors
@@ -174,13 +394,23 @@ typedef TapkiVec(int64_t) TapkiIntVec;
 // --- Maps
 #define TapkiMapDeclare(Name, K, V) \
     typedef struct{ const K key; V value; } Name##_Pair; \
-    typedef TapkiVec(Name##_Pair) Name; \
     typedef const K Name##_Key; \
     typedef V Name##_Value; \
+    typedef struct { Name##_Pair* d; size_t size; size_t cap; Name##_Key* frozen; uint32_t* frozen_idx; } Name; \
     Name##_Value* Name##_Find(const Name* map, Name##_Key key); \
     Name##_Value* Name##_At(TapkiArena* arena, Name* map, Name##_Key key); \
-    bool Name##_Erase(Name* map, Name##_Key key) \
-
+    bool Name##_Erase(Name* map, Name##_Key key); \
+    void Name##_BuildFrom(TapkiArena* arena, Name* map, const Name##_Pair* pairs, size_t count); \
+    void Name##_Finalize(TapkiArena* arena, Name* map); \
+    void Name##_Freeze(TapkiArena* arena, Name* map) \
+
+// Bulk loading: Name##_BuildFrom() appends pairs unsorted (cheap), then Name##_Finalize() does
+// a single stable sort + dedupe (last pair wins). Call Finalize() before any other map operation.
+// Name##_Freeze() copies keys into a separate Eytzinger-ordered array, which Name##_Find() then
+// searches branchlessly. Any modification (At/Erase/BuildFrom/Finalize) drops the frozen layout;
+// raw vector operations on the map (TapkiVecPush() etc.) do not, so Freeze() again after them.
+// TapkiStrMap/TapkiSStrMap ignore Freeze(): every comparison chases a key pointer anyway, and
+// plain binary search is faster for them (use TapkiStrKeyMap for frozen string lookups).
 #define TapkiMapKT(map) __typeof__((map)->d->key)
 #define TapkiMapVT(map) __typeof__((map)->d->value)
 
@@ -193,6 +423,46 @@ TapkiMapDeclare(TapkiStrMap, char*, TapkiStr);
 
 #define TAPKI_STRING_LESS(l, r) (strcmp((l), (r)) < 0)
 #define TAPKI_STRING_EQ(l, r) (strcmp((l), (r)) == 0)
+
+// Same surface as TapkiMapDeclare, but open addressing (linear probing) instead of sorted vector.
+// Pairs are not ordered. Pointers to values are invalidated by insertion (rehash) and erase.
+#define TapkiHashMapDeclare(Name, K, V) \
+    typedef struct{ const K key; V value; } Name##_Pair; \
+    typedef struct { Name##_Pair* d; uint32_t* hashes; size_t size; size_t cap; } Name; \
+    typedef const K Name##_Key; \
+    typedef V Name##_Value; \
+    Name##_Value* Name##_Find(const Name* map, Name##_Key key); \
+    Name##_Value* Name##_At(TapkiArena* arena, Name* map, Name##_Key key); \
+    bool Name##_Erase(Name* map, Name##_Key key) \
+
+#define TapkiHashMapForEach(map, it) \
+    for (TapkiVecT(map)* it = (TapkiVecT(map)*)__tapki_hashmap_next((map), NULL, TapkiVecS(map)); \
+        it; it = (TapkiVecT(map)*)__tapki_hashmap_next((map), it, TapkiVecS(map)))
+
+TapkiHashMapDeclare(TapkiStrHashMap, char*, TapkiStr);
+
+#define TapkiHashMapImplement(Name, Hash, Eq) TapkiHashMapImplement1(Name, Hash, Eq)
+
+// Optional string key for maps: first 8 bytes (packed big-endian) and length are stored inline,
+// so most comparisons finish without dereferencing the string. Strings must not contain '\0'.
+// Keys sharing a long prefix (e.g. "symbol_...") gain nothing: every comparison then reads
+// the strings, and TapkiStrMap or TapkiStrHashMap is faster for them (see bench.c).
+typedef struct TapkiStrKey {
+    uint64_t prefix;
+    size_t len;
+    const char* s;
+} TapkiStrKey;
+
+TapkiStrKey TapkiStrKeyOf(const char* s);
+
+TapkiMapDeclare(TapkiStrKeyMap, TapkiStrKey, TapkiStr);
+
+#define TAPKI_TRIVIAL_HASH(x) __tapki_hash_u64((uint64_t)(x))
+#define TAPKI_STRING_HASH(s) __tapki_hash_str(s)
+
+#define TAPKI_STRKEY_LESS(l, r) (__tapki_strkey_cmp((l), (r)) < 0)
+#define TAPKI_STRKEY_EQ(l, r) __tapki_strkey_eq((l), (r))
+#define TAPKI_STRKEY_HASH(k) __tapki_strkey_hash(k)
 // ---
 
 // --- Strings
@@ -202,8 +472,13 @@ TapkiMapDeclare(TapkiStrMap, char*, TapkiStr);
 TapkiStr TapkiStrSub(TapkiArena *ar, const char* target, size_t from, size_t to);
 TAPKI_FMT_ATTR(3, 4) TapkiStr* TapkiStrAppendF(TapkiArena *ar, TapkiStr* str, const char* TAPKI_RESTRICT fmt, ...);
 TapkiStr* TapkiStrAppendVF(TapkiArena *ar, TapkiStr* str, const char* TAPKI_RESTRICT fmt, va_list list);
+TapkiStr* TapkiStrAppendI64(TapkiArena *ar, TapkiStr* str, int64_t v);
+TapkiStr* TapkiStrAppendU64(TapkiArena *ar, TapkiStr* str, uint64_t v);
+// Shortest of %.15g, %.16g, %.17g that parses back to exactly v (subnormals: from %.1g)
+TapkiStr* TapkiStrAppendDouble(TapkiArena *ar, TapkiStr* str, double v);
 size_t TapkiStrFind(const char* target, const char* what, size_t offset);
 TapkiStr TapkiStrCopy(TapkiArena *ar, const char* target, size_t len);
+// Empty needle is found at 0 (unlike TapkiSV_RevFind, which returns size)
 size_t TapkiStrRevFind(const char* target, const char* what);
 bool TapkiStrContains(const char* target, const char* what);
 bool TapkiStrStartsWith(const char* target, const char* what);
@@ -220,24 +495,178 @@ uint64_t TapkiToU64(const char* s);
 double TapkiToFloat(const char* s);
 // ---
 
+// --- String views
+// Non-owning slice: d is not required to be '\0'-terminated. TapkiSV_* functions work on
+// explicit lengths and never rescan with strlen(). TapkiSV() accepts TapkiStr or TapkiStrView.
+typedef struct TapkiStrView {
+    const char* d;
+    size_t size;
+} TapkiStrView;
+
+#define TapkiSV(str) ((TapkiStrView){(str).d, (str).size})
+TapkiStrView TapkiSV_Of(const char* s);
+TapkiStrView TapkiSV_Sub(TapkiStrView s, size_t from, size_t to);
+size_t TapkiSV_Find(TapkiStrView s, TapkiStrView what, size_t offset);
+size_t TapkiSV_RevFind(TapkiStrView s, TapkiStrView what);
+bool TapkiSV_Contains(TapkiStrView s, TapkiStrView what);
+bool TapkiSV_StartsWith(TapkiStrView s, TapkiStrView what);
+bool TapkiSV_EndsWith(TapkiStrView s, TapkiStrView what);
+bool TapkiSV_Eq(TapkiStrView l, TapkiStrView r);
+TapkiStr TapkiSV_Copy(TapkiArena* ar, TapkiStrView s);
+TapkiStrVec TapkiSV_Split(TapkiArena* ar, TapkiStrView s, TapkiStrView delim);
+TapkiStr* TapkiStrAppendSV(TapkiArena* ar, TapkiStr* str, TapkiStrView s);
+
+// Zero-copy split: pieces point into source buffer, which must outlive them.
+typedef TapkiVec(TapkiStrView) TapkiStrViewVec;
+TapkiStrViewVec TapkiSV_SplitViews(TapkiArena* ar, TapkiStrView s, TapkiStrView delim);
+TapkiStrViewVec TapkiStrSplitViews(TapkiArena* ar, const char* target, const char* delim);
+
+// Streaming split without any allocation. Yields same pieces as TapkiSV_Split().
+// rest is advanced past each token; exhausted rest is {NULL, Tapki_npos}. View with d == NULL
+// and size 0 is an empty string (one empty token), same as in TapkiSV_Split(). Example:
+// StrView rest = SV(text), line;
+// while (StrSplitNext(&rest, SVOf("\n"), &line)) { ... }
+bool TapkiStrSplitNext(TapkiStrView* rest, TapkiStrView delim, TapkiStrView* token);
+// ---
+
+// --- Multi-pattern search
+// Aho-Corasick automaton (DFA over byte classes): all needles are searched in a single pass.
+// Matches are reported in order of their end position; among matches ending at the same byte
+// the longest wins. Empty needles never match, duplicates are reported under the first index.
+typedef struct TapkiMatcher TapkiMatcher;
+
+typedef struct TapkiMatch {
+    size_t pos;
+    size_t needle; // index in needles passed to TapkiMatcherCreate()
+} TapkiMatch;
+
+typedef TapkiVec(TapkiMatch) TapkiMatchVec;
+
+TapkiMatcher* TapkiMatcherCreate(TapkiArena* ar, const char* const* needles, size_t count);
+// Returns start of first match at or after offset (or Tapki_npos). needle may be NULL
+size_t TapkiMatcherFind(const TapkiMatcher* m, TapkiStrView s, size_t offset, size_t* needle);
+// All (possibly overlapping) matches
+TapkiMatchVec TapkiMatcherFindAll(TapkiArena* ar, const TapkiMatcher* m, TapkiStrView s);
+// ---
+
+// --- Parsing
+// Non-fatal, locale-independent parsing of a whole view: [+-]digits for integers (no '-' for
+// unsigned), [+-]digits[.digits][(e|E)[+-]digits] (or inf/nan) for doubles. No whitespace skipping.
+// *out is written only on TAPKI_PARSE_OK.
+typedef enum TapkiParseErr {
+    TAPKI_PARSE_OK = 0,
+    TAPKI_PARSE_EMPTY, // no digits
+    TAPKI_PARSE_INVALID, // unexpected character
+    TAPKI_PARSE_RANGE, // does not fit into type
+} TapkiParseErr;
+
+TapkiParseErr TapkiParseI32(TapkiStrView s, int32_t* out);
+TapkiParseErr TapkiParseU32(TapkiStrView s, uint32_t* out);
+TapkiParseErr TapkiParseI64(TapkiStrView s, int64_t* out);
+TapkiParseErr TapkiParseU64(TapkiStrView s, uint64_t* out);
+TapkiParseErr TapkiParseDouble(TapkiStrView s, double* out);
+const char* TapkiParseErrStr(TapkiParseErr err);
+// Appends delim-separated integers to out (trailing delim is allowed).
+// On error *bad (if not NULL) is set to offset of failed field; values before it are kept.
+TapkiParseErr TapkiParseI64Bulk(TapkiArena* ar, TapkiStrView s, char delim, TapkiIntVec* out, size_t* bad);
+// ---
+
+// --- Small strings
+// 24 bytes: up to TAPKI_SSTR_INLINE chars are stored inline (no arena allocation),
+// longer strings move to the arena. Zero-initialized value is an empty string.
+#define TAPKI_SSTR_INLINE 22
+#define TAPKI_SSTR_HEAP 0xFF
+
+typedef union TapkiSStr {
+    struct { char d[TAPKI_SSTR_INLINE + 1]; uint8_t tag; } sso; // tag = size
+    struct { char* d; uint32_t size; uint32_t cap; char __pad[TAPKI_SSTR_INLINE - 7 - sizeof(char*)]; uint8_t tag; } heap;
+} TapkiSStr;
+
+#define TapkiSStrIsInline(s) ((s)->sso.tag != TAPKI_SSTR_HEAP)
+#define TapkiSStrData(s) (TapkiSStrIsInline(s) ? (const char*)(s)->sso.d : (const char*)(s)->heap.d)
+#define TapkiSStrSize(s) (TapkiSStrIsInline(s) ? (size_t)(s)->sso.tag : (size_t)(s)->heap.size)
+#define TapkiSStrFind(s, needle, offs) TapkiStrFind(TapkiSStrData(s), needle, offs)
+#define TapkiSStrView(s) ((TapkiStrView){TapkiSStrData(s), TapkiSStrSize(s)})
+#define TapkiSStrAppend(arena, s, ...) __tapkiss_append((arena), (s), __TapkiArr(const char*, __VA_ARGS__))
+
+TapkiSStr TapkiSS(TapkiArena* ar, const char* s);
+TapkiSStr TapkiSStrCopy(TapkiArena* ar, const char* target, size_t len);
+TAPKI_FMT_ATTR(3, 4) TapkiSStr* TapkiSStrAppendF(TapkiArena *ar, TapkiSStr* str, const char* TAPKI_RESTRICT fmt, ...);
+TapkiSStr* TapkiSStrAppendVF(TapkiArena *ar, TapkiSStr* str, const char* TAPKI_RESTRICT fmt, va_list list);
+
+TapkiMapDeclare(TapkiSStrMap, char*, TapkiSStr);
+// ---
+
 // --- Files
+typedef enum TapkiMapAdvice {
+    TAPKI_MAP_NORMAL,
+    TAPKI_MAP_SEQUENTIAL, // aggressive read-ahead, pages behind may be dropped early
+    TAPKI_MAP_RANDOM, // no read-ahead
+    TAPKI_MAP_WILLNEED, // start reading the whole file in background
+} TapkiMapAdvice;
+
 TapkiStr TapkiFileRead(TapkiArena* ar, const char* file);
+// Reads files concurrently (io_uring on Linux, a pool of threads elsewhere), results are in order of paths
+TapkiStrVec TapkiFileReadMany(TapkiArena* ar, const char* const* paths, size_t count);
+// Maps file read-only until arena is freed, cleared or restored to a mark before this call.
+// View is not NUL-terminated. Falls back to TapkiFileRead where mmap is unavailable
+TapkiStrView TapkiFileMap(TapkiArena* ar, const char* file, TapkiMapAdvice advice);
+void TapkiFileAdvise(TapkiStrView view, TapkiMapAdvice advice);
+
+// Streaming reader: returned views stay valid until the next call on the same reader
+typedef struct TapkiReader TapkiReader;
+// "-" reads stdin. File is closed at end of input or by TapkiReaderClose
+TapkiReader* TapkiReaderOpen(TapkiArena* ar, const char* path);
+// fd is not closed by reader
+TapkiReader* TapkiReaderOpenFd(TapkiArena* ar, int fd);
+// Line without '\n' and trailing '\r'. Last line may lack '\n'
+bool TapkiReaderNextLine(TapkiReader* r, TapkiStrView* line);
+bool TapkiReaderNextRecord(TapkiReader* r, char delim, TapkiStrView* record);
+void TapkiReaderClose(TapkiReader* r);
+
+typedef enum TapkiWriteMode {
+    TAPKI_WRITE_TRUNCATE,
+    TAPKI_WRITE_APPEND,
+    TAPKI_WRITE_ATOMIC, // write to temporary file next to path, rename over path on close
+} TapkiWriteMode;
+
+// Buffered writer. Data is not written until buffer fills, Flush or Close: always close writers
+typedef struct TapkiWriter TapkiWriter;
+// "-" writes to stdout
+TapkiWriter* TapkiWriterOpen(TapkiArena* ar, const char* path, TapkiWriteMode mode);
+// fd is not closed by writer
+TapkiWriter* TapkiWriterOpenFd(TapkiArena* ar, int fd);
+void TapkiWriterAppend(TapkiWriter* w, const void* data, size_t len);
+// Strings that do not fit the buffer are written together in one writev()
+void TapkiWriterAppendStrs(TapkiWriter* w, const TapkiStr* strs, size_t count);
+void TapkiWriterFlush(TapkiWriter* w);
+// Flushes, closes file and (in atomic mode) syncs it and renames over target
+void TapkiWriterClose(TapkiWriter* w);
 void TapkiFileWrite(const char* file, const char* contents);
 void TapkiFileAppend(const char* file, const char* contents);
 #define TapkiPathJoin(arena, ...) __tpk_path_join(arena, __TapkiArr(const char*, __VA_ARGS__))
 // ---
 
 // --- Tracebacks
-#ifdef _MSC_VER
+// Frame messages are formatted only by TapkiTraceback(): arguments are captured by value,
+// so strings passed for %s must stay alive (and are shown as they are at the time of Die).
+// Formats with more than 12 arguments or unknown conversions are formatted eagerly instead,
+// truncated to 96 bytes with terminator (was 124 before lazy capture).
+// With TAPKI_NO_FRAMES frames compile to plain blocks, arguments are not evaluated.
+#if defined(TAPKI_NO_FRAMES) && defined(_MSC_VER)
+#define TapkiFrameF(fmt, ...) for (int __tpk_f = 0 ? ((void)snprintf(NULL, 0, fmt ? fmt : "!", __VA_ARGS__), 0) : 0; !__tpk_f; __tpk_f = 1)
+#elif defined(TAPKI_NO_FRAMES)
+#define TapkiFrameF(fmt, ...) for (int __tpk_f = 0 ? ((void)snprintf(NULL, 0, fmt ? fmt : "!", ##__VA_ARGS__), 0) : 0; !__tpk_f; __tpk_f = 1)
+#elif defined(_MSC_VER)
 #define TapkiFrameF(fmt, ...) for( \
     __tpk_scope __scope = {__FILE__":"__TPK_STR(__LINE__), __func__}; \
-    !__scope.__f && (fmt ? snprintf(__scope.msg, sizeof(__scope.msg), fmt ? fmt : "!", __VA_ARGS__) : (void)0, __tpk_frame_start(&__scope), 1); \
+    !__scope.__f && (__tpk_frame_startf(&__scope, fmt, __VA_ARGS__), 1); \
     __tpk_frame_end(), __scope.__f = 1 \
 )
 #else
-#define TapkiFrameF(fmt, ...) for (                                                                                                               \
-    __tpk_scope __scope = { __FILE__ ":"__TPK_STR(__LINE__), __func__ };                                                                          \
-    !__scope.__f && (fmt ? snprintf(__scope.msg, sizeof(__scope.msg), fmt ? fmt : "!", ##__VA_ARGS__) : (void)0, __tpk_frame_start(&__scope), 1); \
+#define TapkiFrameF(fmt, ...) for (                                                  \
+    __tpk_scope __scope = { __FILE__ ":"__TPK_STR(__LINE__), __func__ };             \
+    !__scope.__f && (__tpk_frame_startf(&__scope, fmt, ##__VA_ARGS__), 1);            \
     __tpk_frame_end(), __scope.__f = 1)
 #endif
 
@@ -246,6 +675,31 @@ void TapkiFileAppend(const char* file, const char* contents);
 TapkiStr TapkiTraceback(TapkiArena* arena);
 // ---
 
+// --- Profiler
+// Samples TapkiFrame stacks of running threads on SIGPROF, hz times per second of process CPU time.
+// Frames are labeled "func (file:line) fmt" (format, not formatted message). hz must be positive.
+// Stop leaves SIGPROF ignored if it had default action. No-op on Windows
+void TapkiProfilerStart(int hz);
+void TapkiProfilerStop(void);
+// Forgets collected samples (profiler must be stopped)
+void TapkiProfilerReset(void);
+// Folded stacks: one "outer;inner count" line per stack (flamegraph.pl, inferno, speedscope)
+TapkiStr TapkiProfilerFolded(TapkiArena* arena);
+// ---
+
+// --- Frame timing
+// While on, every frame adds its time and a call to totals of its location (per thread, no locks).
+// With trace each scope is also kept as event (up to TAPKI_TRACE_EVENTS per thread).
+// Reports read other threads' data without synchronization: call them when workers are idle
+void TapkiFrameTimingStart(bool trace);
+void TapkiFrameTimingStop(void);
+void TapkiFrameTimingReset(void);
+// Table of locations sorted by self time (time not spent in nested frames)
+TapkiStr TapkiFrameReport(TapkiArena* arena);
+// Chrome trace-event JSON (chrome://tracing, Perfetto, speedscope)
+TapkiStr TapkiFrameTraceJSON(TapkiArena* arena);
+// ---
+
 
 // --- CLI
 typedef struct TapkiCLIVarsResult {
@@ -284,10 +738,23 @@ TapkiStr TapkiCLI_Help(TapkiArena *ar, const TapkiCLI cli[]);
 #ifndef TAPKI_FULL_NAMESPACE
 
 typedef TapkiArena Arena;
+typedef TapkiArenaPos ArenaPos;
+typedef TapkiArenaStats ArenaStats;
 typedef TapkiStr Str;
 typedef TapkiStrMap StrMap;
+typedef TapkiStrHashMap StrHashMap;
+typedef TapkiStrKeyMap StrKeyMap;
 typedef TapkiStrVec StrVec;
+typedef TapkiSStr SStr;
+typedef TapkiSStrMap SStrMap;
+typedef TapkiStrView StrView;
+typedef TapkiStrViewVec StrViewVec;
 typedef TapkiIntVec IntVec;
+typedef TapkiMatcher Matcher;
+typedef TapkiMatch Match;
+typedef TapkiMatchVec MatchVec;
+typedef TapkiReader Reader;
+typedef TapkiWriter Writer;
 typedef TapkiCLI CLI;
 
 #endif
@@ -299,12 +766,18 @@ typedef TapkiCLI CLI;
 // --- Private stuff
 
 
-#define TapkiMapImplement1(Name, Less, Eq) \
+#define TapkiMapImplement1(Name, Less, Eq) TapkiMapImplement2(Name, Less, Eq, 1)
+#define TapkiMapImplement2(Name, Less, Eq, Freezable) \
 static bool __##Name##_eq(const void* _lhs, const void* _rhs) { \
     Name##_Key lhs = *(Name##_Key*)_lhs; \
     Name##_Key rhs = *(Name##_Key*)_rhs; \
     return Eq(lhs, rhs); \
 } \
+static bool __##Name##_less(const void* _lhs, const void* _rhs) { \
+    Name##_Key lhs = *(Name##_Key*)_lhs; \
+    Name##_Key rhs = *(Name##_Key*)_rhs; \
+    return Less(lhs, rhs); \
+} \
 static void* __##Name##_lower_bound(const void* _begin, const void* _end, const void* _key) { \
     Name##_Pair* begin = (Name##_Pair*)_begin; \
     Name##_Pair* end = (Name##_Pair*)_end; \
@@ -325,8 +798,19 @@ static void* __##Name##_lower_bound(const void* _begin, const void* _end, const
     } \
     return begin; \
 } \
+static size_t __##Name##_frozen_lower_bound(const void* _keys, size_t n, const void* _key) { \
+    const Name##_Key* keys = (const Name##_Key*)_keys; \
+    Name##_Key key = *(Name##_Key*)_key; \
+    size_t k = 1; \
+    while (k <= n) { \
+        TAPKI_PREFETCH(keys + k * 16); \
+        k = 2 * k + (Less(keys[k], key) ? 1 : 0); \
+    } \
+    return k >> (__tpk_ctz64(~(uint64_t)k) + 1); \
+} \
 static const __tpk_map_info __##Name##_info = { \
-    __##Name##_eq, __##Name##_lower_bound, \
+    __##Name##_eq, __##Name##_less, __##Name##_lower_bound, \
+    (Freezable) ? __##Name##_frozen_lower_bound : NULL, \
     sizeof(Name##_Key), sizeof(Name##_Pair), \
     _Alignof(Name##_Pair), offsetof(Name##_Pair, value) \
 }; \
@@ -338,6 +822,41 @@ Name##_Value *Name##_Find(const Name *map, Name##_Key key) {  \
 } \
 bool Name##_Erase(Name *map, Name##_Key key) { \
     return __tapki_map_erase(map, &key, &__##Name##_info); \
+} \
+void Name##_BuildFrom(TapkiArena *ar, Name *map, const Name##_Pair* pairs, size_t count) { \
+    map->frozen = NULL; \
+    __tapki_vec_append(ar, map, pairs, count, sizeof(Name##_Pair), _Alignof(Name##_Pair)); \
+} \
+void Name##_Finalize(TapkiArena *ar, Name *map) { \
+    __tapki_map_finalize(ar, map, &__##Name##_info); \
+} \
+void Name##_Freeze(TapkiArena *ar, Name *map) { \
+    __tapki_map_freeze(ar, map, &__##Name##_info); \
+} bool Name##_Erase(Name *map, Name##_Key key)
+
+#define TapkiHashMapImplement1(Name, Hash, Eq) \
+static bool __##Name##_eq(const void* _lhs, const void* _rhs) { \
+    Name##_Key lhs = *(Name##_Key*)_lhs; \
+    Name##_Key rhs = *(Name##_Key*)_rhs; \
+    return Eq(lhs, rhs); \
+} \
+static uint64_t __##Name##_hash(const void* _key) { \
+    Name##_Key key = *(Name##_Key*)_key; \
+    return Hash(key); \
+} \
+static const __tpk_hashmap_info __##Name##_info = { \
+    __##Name##_eq, __##Name##_hash, \
+    sizeof(Name##_Key), sizeof(Name##_Pair), \
+    _Alignof(Name##_Pair), offsetof(Name##_Pair, value) \
+}; \
+Name##_Value *Name##_At(TapkiArena *ar, Name *map, Name##_Key key) {  \
+    return (Name##_Value*)__tapki_hashmap_at(ar, map, &key, &__##Name##_info);  \
+} \
+Name##_Value *Name##_Find(const Name *map, Name##_Key key) {  \
+    return (Name##_Value*)__tapki_hashmap_find(map, &key, &__##Name##_info);  \
+} \
+bool Name##_Erase(Name *map, Name##_Key key) { \
+    return __tapki_hashmap_erase(map, &key, &__##Name##_info); \
 } bool Name##_Erase(Name *map, Name##_Key key)
 
 #define __TapkiArr(t, ...) (t[]){__VA_ARGS__}, PP_NARG(__VA_ARGS__)
@@ -353,35 +872,128 @@ void* __tapki_vec_insert(TapkiArena* ar, void* _vec, size_t idx, size_t tsz, siz
 char* __tapki_vec_reserve(TapkiArena* ar, void* _vec, size_t count, size_t tsz, size_t al);
 char* __tapki_vec_resize(TapkiArena* ar, void* _vec, size_t count, size_t tsz, size_t al);
 bool __tapki_vec_shrink(TapkiArena* ar, void* _vec, size_t tsz);
-void __tapki_vec_append(TapkiArena* ar, void* _vec, void* data, size_t count, size_t tsz, size_t al);
+void __tapki_vec_append(TapkiArena* ar, void* _vec, const void* data, size_t count, size_t tsz, size_t al);
 TapkiStr* __tapkis_append(TapkiArena *ar, TapkiStr* target, const char **src, size_t count);
+TapkiSStr* __tapkiss_append(TapkiArena *ar, TapkiSStr* target, const char **src, size_t count);
 void __tapki_vec_erase(void* _vec, size_t idx, size_t tsz);
 
 typedef struct {
     bool(*eq)(const void* lhs, const void* rhs);
+    bool(*less)(const void* lhs, const void* rhs);
     void*(*lower_bound)(const void* beg, const void* end, const void* key);
+    size_t(*frozen_lower_bound)(const void* keys, size_t count, const void* key);
     int key_sizeof;
     int pair_sizeof;
     int pair_align;
     int value_offset;
 } __tpk_map_info;
 
+typedef struct {
+    char* d;
+    size_t size;
+    size_t cap;
+    char* frozen; // 1-based Eytzinger-ordered keys
+    uint32_t* frozen_idx; // frozen slot -> pair index
+} __TapkiMap;
+
 void* __tapki_map_at(TapkiArena *ar, void* _map, const void* key, const __tpk_map_info* info);
 void* __tapki_map_find(const void* _map, const void* key, const __tpk_map_info* info);
 bool __tapki_map_erase(void *map, const void *key, const __tpk_map_info* info);
+void __tapki_map_finalize(TapkiArena *ar, void *_map, const __tpk_map_info* info);
+void __tapki_map_freeze(TapkiArena *ar, void *_map, const __tpk_map_info* info);
+
+typedef struct {
+    char* d;
+    uint32_t* hashes; // 0 -> empty slot
+    size_t size;
+    size_t cap; // always power of 2
+} __TapkiHashMap;
+
+typedef struct {
+    bool(*eq)(const void* lhs, const void* rhs);
+    uint64_t(*hash)(const void* key);
+    int key_sizeof;
+    int pair_sizeof;
+    int pair_align;
+    int value_offset;
+} __tpk_hashmap_info;
+
+void* __tapki_hashmap_at(TapkiArena *ar, void* _map, const void* key, const __tpk_hashmap_info* info);
+void* __tapki_hashmap_find(const void* _map, const void* key, const __tpk_hashmap_info* info);
+bool __tapki_hashmap_erase(void *_map, const void *key, const __tpk_hashmap_info* info);
+void* __tapki_hashmap_next(const void *_map, const void *it, size_t pair_sizeof);
+uint64_t __tapki_hash_str(const char* s);
+
+static inline int __tapki_strkey_cmp(TapkiStrKey l, TapkiStrKey r) {
+    if (l.prefix != r.prefix) return l.prefix < r.prefix ? -1 : 1;
+    // Equal prefixes and one of strings fits in it -> shorter one is a prefix of the other
+    if (l.len <= 8 || r.len <= 8) return (l.len > r.len) - (l.len < r.len);
+    return strcmp(l.s + 8, r.s + 8);
+}
+
+static inline bool __tapki_strkey_eq(TapkiStrKey l, TapkiStrKey r) {
+    return l.prefix == r.prefix && l.len == r.len && (l.len <= 8 || memcmp(l.s + 8, r.s + 8, l.len - 8) == 0);
+}
+
+static inline int __tpk_ctz64(uint64_t x) {
+#ifdef __GNUC__
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (int)idx;
+#else
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
+}
+
+static inline uint64_t __tapki_hash_u64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline uint64_t __tapki_strkey_hash(TapkiStrKey k) {
+    return k.len <= 8 ? __tapki_hash_u64(k.prefix ^ k.len) : __tapki_hash_str(k.s);
+}
+
+typedef struct {
+    TapkiArenaPos pos;
+    int __f;
+} __tpk_arena_scope;
 
 #define __TPK_STR2(x) #x
 #define __TPK_STR(x) __TPK_STR2(x)
 
+typedef union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    const void* p;
+} __tpk_frame_arg;
+
+#define __TPK_FRAME_ARGS 12
+
 typedef struct {
     const char* loc;
     const char* func;
-    char msg[124];
+    const char* fmt; // format of captured args, NULL if msg is formatted already (or empty)
+    uint64_t start_ns; // set only while frame timing is on
+    uint64_t child_ns; // time of nested timed frames
+    union {
+        __tpk_frame_arg args[__TPK_FRAME_ARGS];
+        char msg[__TPK_FRAME_ARGS * sizeof(__tpk_frame_arg)];
+    } data;
     int __f;
 } __tpk_scope;
 
 void __tpk_frame_start(__tpk_scope* scope);
-void __tpk_frame_vstart(__tpk_scope* scope, ...);
+TAPKI_FMT_ATTR(2, 3) void __tpk_frame_startf(__tpk_scope* scope, const char* fmt, ...);
 void __tpk_frame_end();
 
 typedef struct __tpk_frame {
@@ -391,6 +1003,7 @@ typedef struct __tpk_frame {
 typedef struct __tpk_frames {
     TapkiVec(__tpk_frame) frames;
     TapkiArena* arena;
+    struct __tpk_timing* timing;
 } __tpk_frames;
 
 extern TAPKI_THREAD_LOCAL __tpk_frames __tpk_gframes;
@@ -398,7 +1011,12 @@ extern TAPKI_THREAD_LOCAL __tpk_frames __tpk_gframes;
 
 static inline void* __tapki_vec_push(TapkiArena* ar, void* _vec, size_t tsz, size_t al) {
     __TapkiVec* vec = (__TapkiVec*)_vec;
-    return (vec->size >= vec->cap ? __tapki_vec_reserve(ar, vec, vec->cap + 1, tsz, al) : vec->d) + (vec->size++ * tsz);
+    // strings also need room for '\0' after the pushed char
+    if (vec->size + (tsz == 1) >= vec->cap)
+        __tapki_vec_reserve(ar, vec, vec->cap + 1, tsz, al);
+    char* result = vec->d + vec->size++ * tsz;
+    memset(result, 0, tsz + (tsz == 1));
+    return result;
 }
 
 static inline void* __tapki_vec_pop(void* _vec, size_t tsz) {
@@ -467,8 +1085,15 @@ static inline void* __tapki_vec_at(void* _vec, size_t pos, size_t tsz) {
 
 #include <assert.h>
 #include <errno.h>
+#include <locale.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -481,23 +1106,221 @@ static const char* __tpk_sep = "\\";
 static const char* __tpk_sep = "/";
 #endif
 
-#define _TAPKI_MEMCPY(dest, src, count) if (src && count) memcpy(dest, src, count)
+#define _TAPKI_MEMCPY(dest, src, count) if ((src) && (count) != 0) memcpy(dest, src, count)
 
 TAPKI_THREAD_LOCAL __tpk_frames __tpk_gframes;
 
+#ifdef __GNUC__
+#define __tpk_signal_fence() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define __tpk_relaxed_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define __tpk_relaxed_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#define __tpk_signal_fence() _ReadWriteBarrier()
+#define __tpk_relaxed_load(p) (*(volatile bool*)(p))
+#define __tpk_relaxed_store(p, v) (*(volatile bool*)(p) = (v))
+#else
+#define __tpk_signal_fence() (void)0
+#define __tpk_relaxed_load(p) (*(p))
+#define __tpk_relaxed_store(p, v) (*(p) = (v))
+#endif
+
+static bool __tpk_timing_on;
+static uint64_t __tpk_now_ns(void);
+static void __tpk_timing_leave(__tpk_frames* frames, __tpk_scope* scope);
+
 void __tpk_frame_start(__tpk_scope *scope)
 {
     struct __tpk_frames* frames = &__tpk_gframes;
+    if (TAPKI_UNLIKELY(__tpk_relaxed_load(&__tpk_timing_on))) {
+        scope->start_ns = __tpk_now_ns();
+    }
     if (TAPKI_UNLIKELY(!frames->arena)) {
         frames->arena = TapkiArenaCreate(1024);
     }
-    *TapkiVecPush(frames->arena, &frames->frames) = (__tpk_frame){scope};
+    size_t size = frames->frames.size;
+    if (TAPKI_UNLIKELY(size == frames->frames.cap)) {
+        TapkiVecReserve(frames->arena, &frames->frames, size + 1);
+    }
+    // Slot is filled before size grows: profiler may read stack from a signal handler at any point
+    frames->frames.d[size].s = scope;
+    __tpk_signal_fence();
+    frames->frames.size = size + 1;
 }
 
 void __tpk_frame_end()
 {
     struct __tpk_frames* frames = &__tpk_gframes;
-    TapkiVecPop(&frames->frames);
+    __tpk_scope* scope = TapkiVecPop(&frames->frames)->s;
+    if (TAPKI_UNLIKELY(scope->start_ns)) {
+        __tpk_timing_leave(frames, scope);
+    }
+}
+
+// Conversion of printf format: %[flags][width][.precision][length]conv
+typedef struct {
+    const char* flags;
+    const char* width;
+    const char* prec; // NULL if none
+    int nflags, nwidth, nprec;
+    char len; // 0, 'H' (hh), 'h', 'l', 'q' (ll), 'z', 'j', 't', 'L'
+    char conv;
+} __tpk_fmt_spec;
+
+enum { __TPK_ARG_BAD, __TPK_ARG_NONE, __TPK_ARG_INT, __TPK_ARG_UINT, __TPK_ARG_DBL, __TPK_ARG_PTR };
+
+static const char* __tpk_fmt_spec_parse(const char* it, __tpk_fmt_spec* spec)
+{
+    spec->flags = it;
+    while (*it == '-' || *it == '+' || *it == ' ' || *it == '#' || *it == '0' || *it == '\'') it++;
+    spec->nflags = (int)(it - spec->flags);
+    spec->width = it;
+    if (*it == '*') it++;
+    else while (*it >= '0' && *it <= '9') it++;
+    spec->nwidth = (int)(it - spec->width);
+    spec->prec = NULL;
+    spec->nprec = 0;
+    if (*it == '.') {
+        spec->prec = ++it;
+        if (*it == '*') it++;
+        else while (*it >= '0' && *it <= '9') it++;
+        spec->nprec = (int)(it - spec->prec);
+    }
+    spec->len = 0;
+    if ((*it == 'h' || *it == 'l') && it[1] == *it) {
+        spec->len = *it == 'h' ? 'H' : 'q';
+        it += 2;
+    } else {
+        switch (*it) {
+        case 'h': case 'l': case 'q': case 'z': case 'j': case 't': case 'L':
+            spec->len = *it++;
+        }
+    }
+    spec->conv = *it;
+    return *it ? it + 1 : it;
+}
+
+static int __tpk_fmt_spec_kind(const __tpk_fmt_spec* spec)
+{
+    switch (spec->conv) {
+    case '%': return __TPK_ARG_NONE;
+    case 'c': return spec->len ? __TPK_ARG_BAD : __TPK_ARG_INT;
+    case 'd': case 'i': return spec->len == 'L' ? __TPK_ARG_BAD : __TPK_ARG_INT;
+    case 'u': case 'o': case 'x': case 'X': return spec->len == 'L' ? __TPK_ARG_BAD : __TPK_ARG_UINT;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        return spec->len ? __TPK_ARG_BAD : __TPK_ARG_DBL;
+    case 's': return spec->len && spec->len != 'l' ? __TPK_ARG_BAD : __TPK_ARG_PTR;
+    case 'p': return spec->len ? __TPK_ARG_BAD : __TPK_ARG_PTR;
+    default: return __TPK_ARG_BAD;
+    }
+}
+
+// Saves arguments by value. False if format has conversions that cannot be captured
+static bool __tpk_frame_capture(__tpk_scope* scope, const char* fmt, va_list list)
+{
+    __tpk_frame_arg* args = scope->data.args;
+    size_t n = 0;
+    for (const char* it = strchr(fmt, '%'); it; it = strchr(it, '%')) {
+        __tpk_fmt_spec spec;
+        it = __tpk_fmt_spec_parse(it + 1, &spec);
+        int kind = __tpk_fmt_spec_kind(&spec);
+        if (kind == __TPK_ARG_BAD) return false;
+        if (kind == __TPK_ARG_NONE) continue;
+        bool wstar = spec.nwidth && *spec.width == '*';
+        bool pstar = spec.nprec && *spec.prec == '*';
+        if (n + wstar + pstar + 1 > __TPK_FRAME_ARGS) return false;
+        if (wstar) args[n++].i = va_arg(list, int);
+        if (pstar) args[n++].i = va_arg(list, int);
+        char len = spec.len;
+        switch (kind) {
+        case __TPK_ARG_INT:
+            args[n++].i = len == 'l' ? va_arg(list, long) : len == 'q' ? va_arg(list, long long)
+                : len == 'z' || len == 't' ? va_arg(list, ptrdiff_t) : len == 'j' ? va_arg(list, intmax_t)
+                : len == 'H' ? (signed char)va_arg(list, int) : len == 'h' ? (short)va_arg(list, int) : va_arg(list, int);
+            break;
+        case __TPK_ARG_UINT:
+            args[n++].u = len == 'l' ? va_arg(list, unsigned long) : len == 'q' ? va_arg(list, unsigned long long)
+                : len == 'z' ? va_arg(list, size_t) : len == 't' ? (uint64_t)va_arg(list, ptrdiff_t)
+                : len == 'j' ? va_arg(list, uintmax_t) : len == 'H' ? (unsigned char)va_arg(list, unsigned)
+                : len == 'h' ? (unsigned short)va_arg(list, unsigned) : va_arg(list, unsigned);
+            break;
+        case __TPK_ARG_DBL:
+            args[n++].f = va_arg(list, double);
+            break;
+        default:
+            args[n++].p = va_arg(list, const void*);
+            break;
+        }
+    }
+    scope->fmt = fmt;
+    return true;
+}
+
+void __tpk_frame_startf(__tpk_scope* scope, const char* fmt, ...)
+{
+    if (fmt) {
+        va_list list;
+        va_start(list, fmt);
+        bool captured = __tpk_frame_capture(scope, fmt, list);
+        va_end(list);
+        if (TAPKI_UNLIKELY(!captured)) {
+            va_start(list, fmt);
+            vsnprintf(scope->data.msg, sizeof(scope->data.msg), fmt, list);
+            va_end(list);
+        }
+    }
+    __tpk_frame_start(scope);
+}
+
+static void __tpk_frame_render(TapkiArena* ar, TapkiStr* out, const __tpk_scope* scope)
+{
+    if (!scope->fmt) {
+        TapkiStrAppend(ar, out, scope->data.msg);
+        return;
+    }
+    const __tpk_frame_arg* arg = scope->data.args;
+    const char* fmt = scope->fmt;
+    while (*fmt) {
+        const char* pct = strchr(fmt, '%');
+        size_t lit = pct ? (size_t)(pct - fmt) : strlen(fmt);
+        __tapki_vec_append(ar, out, fmt, lit, 1, 1);
+        if (!pct) break;
+        __tpk_fmt_spec spec;
+        fmt = __tpk_fmt_spec_parse(pct + 1, &spec);
+        int kind = __tpk_fmt_spec_kind(&spec);
+        if (kind == __TPK_ARG_NONE) {
+            __tapki_vec_append(ar, out, "%", 1, 1, 1);
+            continue;
+        }
+        // Same conversion with stars resolved and length fixed for the captured type
+        char conv[64];
+        int len = snprintf(conv, sizeof(conv), "%%%.*s", spec.nflags, spec.flags);
+        if (spec.nwidth && *spec.width == '*') {
+            len += snprintf(conv + len, sizeof(conv) - len, "%d", (int)(arg++)->i);
+        } else {
+            len += snprintf(conv + len, sizeof(conv) - len, "%.*s", spec.nwidth, spec.width);
+        }
+        if (spec.prec && spec.nprec && *spec.prec == '*') {
+            len += snprintf(conv + len, sizeof(conv) - len, ".%d", (int)(arg++)->i);
+        } else if (spec.prec) {
+            len += snprintf(conv + len, sizeof(conv) - len, ".%.*s", spec.nprec, spec.prec);
+        }
+        const char* lng = (kind == __TPK_ARG_INT || kind == __TPK_ARG_UINT) && spec.conv != 'c' ? "ll"
+            : spec.len == 'l' ? "l" : "";
+        snprintf(conv + len, sizeof(conv) - len, "%s%c", lng, spec.conv);
+        switch (kind) {
+        case __TPK_ARG_INT:
+            if (spec.conv == 'c') TapkiStrAppendF(ar, out, conv, (int)arg->i);
+            else TapkiStrAppendF(ar, out, conv, (long long)arg->i);
+            break;
+        case __TPK_ARG_UINT: TapkiStrAppendF(ar, out, conv, (unsigned long long)arg->u); break;
+        case __TPK_ARG_DBL: TapkiStrAppendF(ar, out, conv, arg->f); break;
+        default:
+            if (spec.conv == 's' && !arg->p) TapkiStrAppend(ar, out, "(null)");
+            else TapkiStrAppendF(ar, out, conv, arg->p);
+            break;
+        }
+        arg++;
+    }
 }
 
 void __tapki_vec_erase(void *_vec, size_t idx, size_t tsz)
@@ -526,9 +1349,9 @@ TapkiStr TapkiTraceback(TapkiArena *arena)
     TapkiFramesIter(frame) {
         TapkiStr msg = TapkiF(arena, "  %-*s in '%s()'", longest, frame->s->loc, frame->s->func);
         TapkiStrAppend(arena, &result, msg.d);
-        if (frame->s->msg[0]) {
+        if (frame->s->fmt ? *frame->s->fmt : frame->s->data.msg[0]) {
             TapkiStrAppend(arena, &result, " => ");
-            TapkiStrAppend(arena, &result, frame->s->msg);
+            __tpk_frame_render(arena, &result, frame->s);
         }
         TapkiStrAppend(arena, &result, "\n");
     }
@@ -584,6 +1407,14 @@ static TapkiStr __tapkis_withn(TapkiArena* ar, size_t res) {
     return str;
 }
 
+// Appended data may point into the vector itself, and large vectors are moved by realloc()
+static const void* __tpk_rebase(const void* data, const char* was, size_t cap, const char* now)
+{
+    uintptr_t p = (uintptr_t)data, old = (uintptr_t)was;
+    if (was && was != now && p >= old && p < old + cap) return now + (p - old);
+    return data;
+}
+
 TapkiStr* __tapkis_append(TapkiArena *ar, TapkiStr *target, const char** strs, size_t count)
 {
     size_t total = 0;
@@ -591,10 +1422,12 @@ TapkiStr* __tapkis_append(TapkiArena *ar, TapkiStr *target, const char** strs, s
     for (size_t i = 0; i < count; ++i) {
         total += (lens[i] = strlen(strs[i]));
     }
+    const char* was = target->d;
+    size_t wasCap = target->cap;
     TapkiVecReserve(ar, target, target->size + total + 1);
     for (size_t i = 0; i < count; ++i) {
         void* out = target->d + target->size;
-        _TAPKI_MEMCPY(out, strs[i], lens[i]);
+        _TAPKI_MEMCPY(out, __tpk_rebase(strs[i], was, wasCap, target->d), lens[i]);
         target->size += lens[i];
     }
     if (target->d) {
@@ -607,30 +1440,111 @@ TapkiStr TapkiStrSub(TapkiArena *ar, const char *target, size_t from, size_t to)
 {
     assert(to >= from);
     if (!target) target = "";
-    size_t tsz = strlen(target);
+    // Do not scan past 'to': target may be much longer than the substring
+    const char* end = to == Tapki_npos ? NULL : (const char*)memchr(target, 0, to);
+    size_t tsz = to == Tapki_npos ? strlen(target) : end ? (size_t)(end - target) : to;
     assert(from <= tsz);
     to = to > tsz ? tsz : to;
-    TapkiStr res = {0};
-    size_t diff = (size_t)(to - from);
-    TapkiVecReserve(ar, &res, diff);
-    _TAPKI_MEMCPY(res.d, target + from, diff);
-    return res;
+    return TapkiStrCopy(ar, target + from, to - from);
 }
 
-/* By liw. */
-static const char *__rev_strstr(const char *haystack, const char *needle) {
-    if (*needle == '\0')
-        return (char *) haystack;
-    const char *result = NULL;
-    for (;;) {
-        const char *p = strstr(haystack, needle);
-        if (p == NULL)
-            break;
-        result = p;
-        haystack = p + 1;
+// --- Substring search
+// Forward search is left to libc (strstr/memmem beat a first/last byte filter).
+// Reverse search has no libc equivalent: candidates are filtered by first and last byte of needle
+// (16/32 positions at a time with SIMD), only then compared fully. Kernel is selected once by CPU detection.
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+// Not declared by glibc without _GNU_SOURCE
+void* memmem(const void* h, size_t hn, const void* n, size_t nn);
+#define __TPK_HAS_MEMMEM 1
+#endif
+
+static const char* __tpk_memmem(const char* h, size_t hn, const char* n, size_t nn)
+{
+    if (!nn) return h;
+    if (nn == 1) return (const char*)memchr(h, n[0], hn);
+#ifdef __TPK_HAS_MEMMEM
+    return (const char*)memmem(h, hn, n, nn);
+#else
+    if (nn > hn) return NULL;
+    const char* last = h + (hn - nn);
+    for (const char* it = h; it <= last; ++it) {
+        it = (const char*)memchr(it, n[0], (size_t)(last - it) + 1);
+        if (!it) return NULL;
+        if (it[nn - 1] == n[nn - 1] && memcmp(it + 1, n + 1, nn - 1) == 0) return it;
     }
-    return result;
+    return NULL;
+#endif
+}
+
+static const char* __tpk_memrmem_scalar(const char* h, size_t hn, const char* n, size_t nn)
+{
+    if (nn > hn) return NULL;
+    for (size_t i = hn - nn + 1; i-- > 0;) {
+        if (h[i] == n[0] && h[i + nn - 1] == n[nn - 1] && memcmp(h + i + 1, n + 1, nn - 1) == 0)
+            return h + i;
+    }
+    return NULL;
+}
+
+typedef const char* (*__tpk_search_fn)(const char* h, size_t hn, const char* n, size_t nn);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(TAPKI_NO_SIMD)
+#include <immintrin.h>
+
+// Bit k is set if position p + k matches first and last byte of needle
+#define __TPK_SEARCH_MASK(p, V, loadu, cmpeq, and, movemask) (uint32_t)movemask(and( \
+    cmpeq(first, loadu((const V*)(p))), cmpeq(last, loadu((const V*)((p) + nn - 1)))))
+
+#define __TPK_SEARCH_KERNEL(sfx, isa, W, V, set1, loadu, cmpeq, and, movemask) \
+__attribute__((target(isa))) \
+static const char* __tpk_memrmem_##sfx(const char* h, size_t hn, const char* n, size_t nn) { \
+    if (nn > hn) return NULL; \
+    size_t i = hn - nn + 1; /* positions [0, i) are not checked yet */ \
+    uint32_t mask; \
+    do { \
+        const V first = set1(n[0]), last = set1(n[nn - 1]); \
+        for (mask = 0; !mask && i >= W; i -= W) { \
+            mask = __TPK_SEARCH_MASK(h + i - W, V, loadu, cmpeq, and, movemask); \
+        } \
+        while (mask) { \
+            int bit = 31 - __builtin_clz(mask); \
+            size_t pos = i + (size_t)bit; \
+            if (memcmp(h + pos + 1, n + 1, nn - 1) == 0) return h + pos; \
+            mask &= ~(1u << bit); \
+        } \
+    } while (i >= W); \
+    return __tpk_memrmem_scalar(h, i + nn - 1, n, nn); \
+}
+
+__TPK_SEARCH_KERNEL(sse2, "sse2", 16, __m128i, _mm_set1_epi8, _mm_loadu_si128, _mm_cmpeq_epi8, _mm_and_si128, _mm_movemask_epi8)
+__TPK_SEARCH_KERNEL(avx2, "avx2", 32, __m256i, _mm256_set1_epi8, _mm256_loadu_si256, _mm256_cmpeq_epi8, _mm256_and_si256, _mm256_movemask_epi8)
+
+static __tpk_search_fn __tpk_memrmem_impl;
+
+static __tpk_search_fn __tpk_search_kernel(void)
+{
+    __tpk_search_fn rev = __atomic_load_n(&__tpk_memrmem_impl, __ATOMIC_RELAXED);
+    if (TAPKI_UNLIKELY(!rev)) {
+        __builtin_cpu_init();
+        rev = __builtin_cpu_supports("avx2") ? __tpk_memrmem_avx2
+            : __builtin_cpu_supports("sse2") ? __tpk_memrmem_sse2 : __tpk_memrmem_scalar;
+        __atomic_store_n(&__tpk_memrmem_impl, rev, __ATOMIC_RELAXED);
+    }
+    return rev;
+}
+#else
+static __tpk_search_fn __tpk_search_kernel(void)
+{
+    return __tpk_memrmem_scalar;
+}
+#endif
+
+static const char* __tpk_memrmem(const char* h, size_t hn, const char* n, size_t nn)
+{
+    if (!nn) return h + hn;
+    return __tpk_search_kernel()(h, hn, n, nn);
 }
+// ---
 
 TapkiStr TapkiStrCopy(TapkiArena *ar, const char* target, size_t len)
 {
@@ -643,23 +1557,22 @@ size_t TapkiStrFind(const char *target, const char *what, size_t offset)
 {
     if (!target) target = "";
     if (!what) what = "";
+    // Only the skipped prefix is measured: find loops must not rescan the whole haystack
+    if (offset && strnlen(target, offset) < offset) return Tapki_npos;
     const char* found = strstr(target + offset, what);
-    if (!found) return Tapki_npos;
-    return (size_t)(found - target);
+    return found ? (size_t)(found - target) : Tapki_npos;
 }
 
 size_t TapkiStrRevFind(const char *target, const char *what)
 {
     if (!target) target = "";
-    if (!what) what = "";
-    const char* found = __rev_strstr(target, what);
+    if (!what || !*what) return 0;
+    const char* found = __tpk_memrmem(target, strlen(target), what, strlen(what));
     return found ? (size_t)(found - target) : Tapki_npos;
 }
 
 bool TapkiStrContains(const char *target, const char *what)
 {
-    if (!target) target = "";
-    if (!what) what = "";
     return TapkiStrFind(target, what, 0) != Tapki_npos;
 }
 
@@ -667,61 +1580,401 @@ bool TapkiStrStartsWith(const char *target, const char *what)
 {
     if (!target) target = "";
     if (!what) what = "";
-    return TapkiStrFind(target, what, 0) == 0;
+    return strncmp(target, what, strlen(what)) == 0;
 }
 
 bool TapkiStrEndsWith(const char *target, const char *what)
 {
-    if (!target) target = "";
-    if (!what) what = "";
-    size_t tlen = strlen(target);
-    size_t wlen = strlen(what);
-    if (wlen > tlen) return false;
-    return TapkiStrFind(target, what, tlen - wlen);
+    return TapkiSV_EndsWith(TapkiSV_Of(target), TapkiSV_Of(what));
 }
 
 TapkiStrVec TapkiStrSplit(TapkiArena *ar, const char *target, const char *delim)
 {
-    if (!target) target = "";
-    if (!delim) delim = "";
+    return TapkiSV_Split(ar, TapkiSV_Of(target), TapkiSV_Of(delim));
+}
+
+TapkiStrView TapkiSV_Of(const char* s)
+{
+    return (TapkiStrView){s ? s : "", s ? strlen(s) : 0};
+}
+
+TapkiStrView TapkiSV_Sub(TapkiStrView s, size_t from, size_t to)
+{
+    assert(to >= from);
+    to = to > s.size ? s.size : to;
+    from = from > to ? to : from;
+    return (TapkiStrView){s.d + from, to - from};
+}
+
+size_t TapkiSV_Find(TapkiStrView s, TapkiStrView what, size_t offset)
+{
+    if (offset > s.size) return Tapki_npos;
+    if (!what.size) return offset;
+    const char* found = __tpk_memmem(s.d + offset, s.size - offset, what.d, what.size);
+    return found ? (size_t)(found - s.d) : Tapki_npos;
+}
+
+size_t TapkiSV_RevFind(TapkiStrView s, TapkiStrView what)
+{
+    if (what.size > s.size) return Tapki_npos;
+    const char* found = __tpk_memrmem(s.d, s.size, what.d, what.size);
+    return found ? (size_t)(found - s.d) : Tapki_npos;
+}
+
+bool TapkiSV_Contains(TapkiStrView s, TapkiStrView what)
+{
+    return TapkiSV_Find(s, what, 0) != Tapki_npos;
+}
+
+bool TapkiSV_StartsWith(TapkiStrView s, TapkiStrView what)
+{
+    return what.size <= s.size && memcmp(s.d, what.d, what.size) == 0;
+}
+
+bool TapkiSV_EndsWith(TapkiStrView s, TapkiStrView what)
+{
+    return what.size <= s.size && memcmp(s.d + s.size - what.size, what.d, what.size) == 0;
+}
+
+bool TapkiSV_Eq(TapkiStrView l, TapkiStrView r)
+{
+    return l.size == r.size && memcmp(l.d, r.d, l.size) == 0;
+}
+
+TapkiStr TapkiSV_Copy(TapkiArena* ar, TapkiStrView s)
+{
+    return TapkiStrCopy(ar, s.d, s.size);
+}
+
+TapkiStrVec TapkiSV_Split(TapkiArena* ar, TapkiStrView s, TapkiStrView delim)
+{
     TapkiStrVec result = {0};
     size_t offs = 0;
-    size_t pos = 0;
-    size_t dsz = strlen(delim);
     while(true) {
-        pos = TapkiStrFind(target, delim, offs);
-        TapkiStr part = TapkiStrSub(ar, target, offs, pos);
-        *TapkiVecPush(ar, &result) = part;
+        size_t pos = delim.size ? TapkiSV_Find(s, delim, offs) : Tapki_npos;
+        *TapkiVecPush(ar, &result) = TapkiSV_Copy(ar, TapkiSV_Sub(s, offs, pos));
         if (pos == Tapki_npos) {
             return result;
         }
-        offs = pos + dsz;
+        offs = pos + delim.size;
     }
 }
 
-typedef struct __TapkiChunk {
-    struct __TapkiChunk* next;
-    size_t cap;
-    char buff[];
+bool TapkiStrSplitNext(TapkiStrView* rest, TapkiStrView delim, TapkiStrView* token)
+{
+    if (!rest->d) {
+        if (rest->size == Tapki_npos) return false;
+        rest->d = "";
+    }
+    size_t pos = delim.size ? TapkiSV_Find(*rest, delim, 0) : Tapki_npos;
+    if (pos == Tapki_npos) {
+        *token = *rest;
+        rest->d = NULL;
+        rest->size = Tapki_npos;
+    } else {
+        *token = (TapkiStrView){rest->d, pos};
+        rest->d += pos + delim.size;
+        rest->size -= pos + delim.size;
+    }
+    return true;
+}
+
+TapkiStrViewVec TapkiSV_SplitViews(TapkiArena* ar, TapkiStrView s, TapkiStrView delim)
+{
+    TapkiStrViewVec result = {0};
+    TapkiStrView tok;
+    while (TapkiStrSplitNext(&s, delim, &tok)) {
+        *TapkiVecPush(ar, &result) = tok;
+    }
+    return result;
+}
+
+TapkiStrViewVec TapkiStrSplitViews(TapkiArena* ar, const char* target, const char* delim)
+{
+    return TapkiSV_SplitViews(ar, TapkiSV_Of(target), TapkiSV_Of(delim));
+}
+
+TapkiStr* TapkiStrAppendSV(TapkiArena* ar, TapkiStr* str, TapkiStrView s)
+{
+    __tapki_vec_append(ar, str, s.d, s.size, 1, 1);
+    return str;
+}
+
+typedef struct __TapkiChunk {
+    struct __TapkiChunk* next;
+    size_t cap;
+    char buff[];
 } __TapkiChunk;
 
-struct TapkiArena {
+typedef struct __TapkiPoolChunk {
+    struct __TapkiPoolChunk* next;
+    size_t cap;
+    size_t used; // atomic
+    size_t _pad; // keeps buff (and carved chunks) 16-aligned
+    char buff[];
+} __TapkiPoolChunk;
+
+typedef struct __TapkiPool {
+    __TapkiPoolChunk* chunks; // atomic, head is carved from
+    TapkiArena* arenas; // atomic, attached arenas
+    TapkiArena* owner;
     size_t chunk_size;
+} __TapkiPool;
+
+// Dedicated block of a large vector
+typedef struct __TapkiLarge {
+    struct __TapkiLarge* next;
+    size_t seq;
+    size_t cap;
+    size_t mapped; // nonzero: block only records a file mapping of this length at *(void**)buff
+    char buff[];
+} __TapkiLarge;
+
+struct TapkiArena {
+    size_t chunk_size; // size of next new chunk
+    size_t max_chunk_size;
     size_t ptr;
     __TapkiChunk* root;
     __TapkiChunk* current;
+    __TapkiLarge* large; // newest first
+    size_t large_seq;
+    __TapkiPool* pool;
+    TapkiArena* next_attached;
+    TapkiArenaStats stats;
 };
 
-static void __TapkiArenaNext(TapkiArena* ar, size_t cap) {
+#ifdef __GNUC__
+#define __tpk_atomic_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define __tpk_atomic_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define __tpk_atomic_cas(p, expected, desired) \
+    __atomic_compare_exchange_n((p), (expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER)
+#ifdef _WIN64
+#define __tpk_atomic_add(p, v) (size_t)_InterlockedExchangeAdd64((volatile __int64*)(p), (__int64)(v))
+#else
+#define __tpk_atomic_add(p, v) (size_t)_InterlockedExchangeAdd((volatile long*)(p), (long)(v))
+#endif
+#define __tpk_atomic_load(p) (*(p)) // volatile reads are acquire on MSVC
+static inline bool __tpk_atomic_cas_ptr(void* volatile* p, void** expected, void* desired) {
+    void* prev = _InterlockedCompareExchangePointer(p, desired, *expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+#define __tpk_atomic_cas(p, expected, desired) __tpk_atomic_cas_ptr((void* volatile*)(p), (void**)(expected), (desired))
+#else
+// No atomics known for this compiler: shared arenas are not thread-safe here
+#define __tpk_atomic_add(p, v) ((*(p) += (v)) - (v))
+#define __tpk_atomic_load(p) (*(p))
+#define __tpk_atomic_cas(p, expected, desired) (*(p) = (desired), true)
+#endif
+
+static __TapkiChunk* __tpk_pool_carve(__TapkiPool* pool, size_t cap) {
+    size_t need = (sizeof(__TapkiChunk) + cap + 15) & ~(size_t)15;
+    __TapkiPoolChunk* head = __tpk_atomic_load(&pool->chunks);
+    if (head && need <= head->cap) {
+        size_t offset = __tpk_atomic_add(&head->used, need);
+        if (offset + need <= head->cap) {
+            return (__TapkiChunk*)(head->buff + offset);
+        }
+    }
+    size_t pcap = need > pool->chunk_size ? need : pool->chunk_size;
+    __TapkiPoolChunk* fresh = (__TapkiPoolChunk*)malloc(sizeof(__TapkiPoolChunk) + pcap);
+    if (TAPKI_UNLIKELY(!fresh)) TapkiDie("arena.pool.chunk.new");
+    fresh->cap = pcap;
+    fresh->used = need;
+    do {
+        fresh->next = head;
+    } while (!__tpk_atomic_cas(&pool->chunks, &head, fresh));
+    return (__TapkiChunk*)fresh->buff;
+}
+
+#ifndef TAPKI_ARENA_CACHE_SIZE
+#define TAPKI_ARENA_CACHE_SIZE (4 * 1024 * 1024)
+#endif
+#define __TAPKI_ARENA_CACHE_STRUCTS 16
+
+typedef struct {
+    __TapkiChunk* chunks;
+    size_t bytes;
+    TapkiArena* arenas; // linked by next_attached
+    size_t arenas_count;
+    bool registered; // thread exit hook is armed
+} __tpk_arena_cache;
+
+static TAPKI_THREAD_LOCAL __tpk_arena_cache __tpk_acache;
+
+#ifndef _WIN32
+#include <pthread.h>
+static pthread_key_t __tpk_acache_key;
+static pthread_once_t __tpk_acache_once = PTHREAD_ONCE_INIT;
+
+static void __tpk_acache_exit(void* cache) {
+    (void)cache;
+    TapkiArenaTrim();
+}
+
+static void __tpk_acache_key_init(void) {
+    (void)pthread_key_create(&__tpk_acache_key, __tpk_acache_exit);
+}
+
+// Exiting threads release their cache from key destructor (main thread leaves it to the OS)
+static void __tpk_acache_register(__tpk_arena_cache* cache) {
+    if (cache->registered) return;
+    cache->registered = true;
+    pthread_once(&__tpk_acache_once, __tpk_acache_key_init);
+    (void)pthread_setspecific(__tpk_acache_key, cache);
+}
+#else
+static void __tpk_acache_register(__tpk_arena_cache* cache) { (void)cache; }
+#endif
+
+#if defined(TAPKI_ARENA_MMAP) && !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#ifndef TAPKI_ARENA_MMAP_MIN
+#define TAPKI_ARENA_MMAP_MIN (256 * 1024)
+#endif
+#define __TAPKI_HUGE_PAGE (2 * 1024 * 1024)
+
+// Whether chunk is mmap-ed is derived from its capacity: mapped sizes are only rounded up
+static bool __tpk_chunk_mapped(size_t cap) {
+    return sizeof(__TapkiChunk) + cap >= TAPKI_ARENA_MMAP_MIN;
+}
+
+static __TapkiChunk* __tpk_chunk_map(size_t cap) {
+    size_t total = sizeof(__TapkiChunk) + cap;
+    size_t page = total >= __TAPKI_HUGE_PAGE ? __TAPKI_HUGE_PAGE : (size_t)sysconf(_SC_PAGESIZE);
+    total = (total + page - 1) & ~(page - 1);
+    void* mem = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (TAPKI_UNLIKELY(mem == MAP_FAILED)) TapkiDie("arena.chunk.mmap: [Errno: %d] %s", errno, strerror(errno));
+#ifdef MADV_HUGEPAGE
+    if (page == __TAPKI_HUGE_PAGE) {
+        (void)madvise(mem, total, MADV_HUGEPAGE);
+    }
+#endif
+    __TapkiChunk* chunk = (__TapkiChunk*)mem;
+    chunk->cap = total - sizeof(__TapkiChunk);
+    return chunk;
+}
+
+static void __tpk_chunk_unmap(__TapkiChunk* chunk) {
+    munmap(chunk, sizeof(__TapkiChunk) + chunk->cap);
+}
+#else
+static bool __tpk_chunk_mapped(size_t cap) { (void)cap; return false; }
+static __TapkiChunk* __tpk_chunk_map(size_t cap) { (void)cap; return NULL; }
+static void __tpk_chunk_unmap(__TapkiChunk* chunk) { (void)chunk; }
+#endif
+
+static __TapkiChunk* __tpk_chunk_alloc(size_t cap) {
+    __tpk_arena_cache* cache = &__tpk_acache;
+    // Reuse cached chunk, if it is not too wasteful
+    for (__TapkiChunk** it = &cache->chunks; *it; it = &(*it)->next) {
+        __TapkiChunk* chunk = *it;
+        if (chunk->cap >= cap && chunk->cap / 2 <= cap) {
+            *it = chunk->next;
+            cache->bytes -= chunk->cap;
+            return chunk;
+        }
+    }
+    __TapkiChunk* chunk;
+    if (__tpk_chunk_mapped(cap)) {
+        chunk = __tpk_chunk_map(cap);
+    } else {
+        chunk = (__TapkiChunk*)malloc(sizeof(__TapkiChunk) + cap);
+        if (TAPKI_UNLIKELY(!chunk)) TapkiDie("arena.chunk.new");
+        chunk->cap = cap;
+    }
+    return chunk;
+}
+
+static void __tpk_chunk_free(__TapkiChunk* chunk) {
+#ifdef ASAN_DEFINE_REGION_MACROS
+    ASAN_UNPOISON_MEMORY_REGION(chunk->buff, chunk->cap);
+#endif
+    if (__tpk_chunk_mapped(chunk->cap)) {
+        __tpk_chunk_unmap(chunk);
+    } else {
+        free(chunk);
+    }
+}
+
+static void __tpk_chunk_release(__TapkiChunk* chunk) {
+    __tpk_arena_cache* cache = &__tpk_acache;
+    if (cache->bytes + chunk->cap <= TAPKI_ARENA_CACHE_SIZE) {
+        // Cached chunks stay poisoned: stale pointers into freed arenas are caught by ASAN.
+        // Reuse needs no unpoison, __TapkiArenaNext() hands chunks out poisoned anyway.
+#ifdef ASAN_DEFINE_REGION_MACROS
+        ASAN_POISON_MEMORY_REGION(chunk->buff, chunk->cap);
+#endif
+        __tpk_acache_register(cache);
+        chunk->next = cache->chunks;
+        cache->chunks = chunk;
+        cache->bytes += chunk->cap;
+    } else {
+        __tpk_chunk_free(chunk);
+    }
+}
+
+static TapkiArena* __tpk_arena_struct_alloc(void) {
+    __tpk_arena_cache* cache = &__tpk_acache;
+    TapkiArena* arena = cache->arenas;
+    if (arena) {
+        cache->arenas = arena->next_attached;
+        cache->arenas_count--;
+    } else {
+        arena = (TapkiArena*)malloc(sizeof(TapkiArena));
+        if (TAPKI_UNLIKELY(!arena)) TapkiDie("arena.new");
+    }
+    return arena;
+}
+
+static void __tpk_arena_struct_release(TapkiArena* arena) {
+    __tpk_arena_cache* cache = &__tpk_acache;
+    if (cache->arenas_count < __TAPKI_ARENA_CACHE_STRUCTS) {
+        __tpk_acache_register(cache);
+        arena->next_attached = cache->arenas;
+        cache->arenas = arena;
+        cache->arenas_count++;
+    } else {
+        free(arena);
+    }
+}
+
+void TapkiArenaTrim(void)
+{
+    __tpk_arena_cache* cache = &__tpk_acache;
+    while (cache->chunks) {
+        __TapkiChunk* next = cache->chunks->next;
+        __tpk_chunk_free(cache->chunks);
+        cache->chunks = next;
+    }
+    while (cache->arenas) {
+        TapkiArena* next = cache->arenas->next_attached;
+        free(cache->arenas);
+        cache->arenas = next;
+    }
+    *cache = (__tpk_arena_cache){0};
+}
+
+static void __TapkiArenaNext(TapkiArena* ar, size_t need) {
     __TapkiChunk* next = ar->current ? ar->current->next : NULL;
     while (next) {
         ar->current = next;
-        if (ar->current->cap > cap) return;
+        if (ar->current->cap >= need) return;
         next = ar->current->next;
     }
-    next = (__TapkiChunk*)malloc(sizeof(__TapkiChunk) + cap);
-    if (TAPKI_UNLIKELY(!next)) TapkiDie("arena.chunk.new");
-    next->cap = cap;
+    size_t cap = need > ar->chunk_size ? need : ar->chunk_size;
+    if (ar->chunk_size < ar->max_chunk_size) {
+        ar->chunk_size = ar->chunk_size * 2 < ar->max_chunk_size ? ar->chunk_size * 2 : ar->max_chunk_size;
+    }
+    if (ar->pool) {
+        next = __tpk_pool_carve(ar->pool, cap);
+        next->cap = cap;
+    } else {
+        next = __tpk_chunk_alloc(cap);
+    }
 #ifdef ASAN_DEFINE_REGION_MACROS
     ASAN_POISON_MEMORY_REGION(next->buff, next->cap);
 #endif
@@ -730,18 +1983,23 @@ static void __TapkiArenaNext(TapkiArena* ar, size_t cap) {
     ar->current = next;
 }
 
-TapkiArena *TapkiArenaCreate(size_t chunkSize)
+TapkiArena *TapkiArenaCreateEx(size_t chunkSize, size_t maxChunkSize)
 {
-    TapkiArena* arena = (TapkiArena*)malloc(sizeof(TapkiArena));
-    if (TAPKI_UNLIKELY(!arena)) TapkiDie("arena.new");
+    TapkiArena* arena = __tpk_arena_struct_alloc();
     *arena = (TapkiArena){};
     arena->chunk_size = chunkSize;
+    arena->max_chunk_size = maxChunkSize;
     __TapkiArenaNext(arena, chunkSize);
     arena->root = arena->current;
     return arena;
 }
 
-void *TapkiArenaAllocAligned(TapkiArena *arena, size_t size, size_t align)
+TapkiArena *TapkiArenaCreate(size_t chunkSize)
+{
+    return TapkiArenaCreateEx(chunkSize, TAPKI_ARENA_MAX_CHUNK_SIZE);
+}
+
+void *TapkiArenaAllocUninit(TapkiArena *arena, size_t size, size_t align)
 {
 #ifdef ASAN_DEFINE_REGION_MACROS
     size_t misalign = align % 8;
@@ -751,17 +2009,29 @@ void *TapkiArenaAllocAligned(TapkiArena *arena, size_t size, size_t align)
     size_t aligned = tail ? arena->ptr + align - tail : arena->ptr;
     size_t end = aligned + size;
     void* result;
+    arena->stats.allocated += size;
     if (TAPKI_UNLIKELY(end > arena->current->cap)) {
-        __TapkiArenaNext(arena, size > arena->chunk_size ? size : arena->chunk_size);
+        size_t left = arena->current->cap - arena->ptr;
+        arena->stats.wasted_tail += left;
+        arena->stats.in_use += left + size;
+        __TapkiArenaNext(arena, size);
         arena->ptr = size;
         result = arena->current->buff;
     } else {
+        arena->stats.wasted_align += aligned - arena->ptr;
+        arena->stats.in_use += end - arena->ptr;
         arena->ptr = end;
         result = arena->current->buff + aligned;
     }
 #ifdef ASAN_DEFINE_REGION_MACROS
     ASAN_UNPOISON_MEMORY_REGION(result, size);
 #endif
+    return result;
+}
+
+void *TapkiArenaAllocAligned(TapkiArena *arena, size_t size, size_t align)
+{
+    void* result = TapkiArenaAllocUninit(arena, size, align);
     if (size) memset(result, 0, size);
     return result;
 }
@@ -776,6 +2046,97 @@ char *TapkiArenaAllocChars(TapkiArena *arena, size_t count)
     return (char*)TapkiArenaAllocAligned(arena, count, 1);
 }
 
+TapkiArenaStats TapkiArenaGetStats(TapkiArena* arena)
+{
+    TapkiArenaStats stats = arena->stats;
+    if (stats.in_use > stats.high_water) stats.high_water = stats.in_use;
+    for (__TapkiChunk* it = arena->root; it; it = it->next) {
+        stats.chunks++;
+        stats.reserved += it->cap;
+        if (it->cap > stats.largest_chunk) stats.largest_chunk = it->cap;
+    }
+    for (__TapkiLarge* it = arena->large; it; it = it->next) {
+        stats.large += it->cap;
+        stats.mapped += it->mapped;
+    }
+    return stats;
+}
+
+// Frees large vector blocks and file mappings created at or after seq
+static void __tpk_large_release(TapkiArena* arena, size_t seq)
+{
+    while (arena->large && arena->large->seq >= seq) {
+        __TapkiLarge* next = arena->large->next;
+#ifndef _WIN32
+        if (arena->large->mapped) {
+            munmap(*(void**)arena->large->buff, arena->large->mapped);
+        }
+#endif
+        free(arena->large);
+        arena->large = next;
+    }
+}
+
+static __TapkiLarge** __tpk_large_find(TapkiArena* arena, const char* data)
+{
+    for (__TapkiLarge** it = &arena->large; *it; it = &(*it)->next) {
+        if ((*it)->buff == data) return it;
+    }
+    return NULL;
+}
+
+// Returns new location of data, growing block in place if possible
+static char* __tpk_large_grow(TapkiArena* arena, char* data, size_t used, size_t cap)
+{
+    __TapkiLarge** found = data ? __tpk_large_find(arena, data) : NULL;
+    __TapkiLarge* block;
+    if (found) {
+        block = (__TapkiLarge*)realloc(*found, sizeof(__TapkiLarge) + cap);
+        if (TAPKI_UNLIKELY(!block)) TapkiDie("arena.large.grow");
+        *found = block;
+    } else {
+        block = (__TapkiLarge*)malloc(sizeof(__TapkiLarge) + cap);
+        if (TAPKI_UNLIKELY(!block)) TapkiDie("arena.large.new");
+        _TAPKI_MEMCPY(block->buff, data, used);
+        block->seq = arena->large_seq++;
+        block->mapped = 0;
+        block->next = arena->large;
+        arena->large = block;
+    }
+    block->cap = cap;
+    return block->buff;
+}
+
+static void __tpk_arena_release_to(TapkiArena* arena, size_t in_use)
+{
+    if (arena->stats.in_use > arena->stats.high_water)
+        arena->stats.high_water = arena->stats.in_use;
+    arena->stats.in_use = in_use;
+}
+
+TapkiArenaPos TapkiArenaMark(TapkiArena* arena)
+{
+    return (TapkiArenaPos){arena->current, arena->ptr, arena->stats.in_use, arena->large_seq};
+}
+
+void TapkiArenaRestore(TapkiArena* arena, TapkiArenaPos pos)
+{
+    __TapkiChunk* chunk = (__TapkiChunk*)pos.chunk;
+#ifdef ASAN_DEFINE_REGION_MACROS
+    ASAN_POISON_MEMORY_REGION(chunk->buff + pos.ptr, chunk->cap - pos.ptr);
+    if (chunk != arena->current) {
+        for (__TapkiChunk* it = chunk->next; it; it = it->next) {
+            ASAN_POISON_MEMORY_REGION(it->buff, it->cap);
+            if (it == arena->current) break;
+        }
+    }
+#endif
+    __tpk_arena_release_to(arena, pos.in_use);
+    __tpk_large_release(arena, pos.large_seq);
+    arena->current = chunk;
+    arena->ptr = pos.ptr;
+}
+
 void TapkiArenaClear(TapkiArena* arena)
 {
 #ifdef ASAN_DEFINE_REGION_MACROS
@@ -783,19 +2144,84 @@ void TapkiArenaClear(TapkiArena* arena)
         ASAN_POISON_MEMORY_REGION(it->buff, it->cap);
     }
 #endif
+    __tpk_arena_release_to(arena, 0);
+    __tpk_large_release(arena, 0);
     arena->ptr = 0;
     arena->current = arena->root;
 }
 
+TapkiArena *TapkiArenaCreateShared(size_t chunkSize)
+{
+    __TapkiPool* pool = (__TapkiPool*)malloc(sizeof(__TapkiPool));
+    TapkiArena* arena = (TapkiArena*)malloc(sizeof(TapkiArena));
+    if (TAPKI_UNLIKELY(!pool || !arena)) TapkiDie("arena.shared.new");
+    *pool = (__TapkiPool){};
+    pool->chunk_size = chunkSize * 8;
+    pool->owner = arena;
+    *arena = (TapkiArena){};
+    arena->chunk_size = chunkSize;
+    arena->max_chunk_size = chunkSize; // pool chunks are sized for fixed carving
+    arena->pool = pool;
+    __TapkiArenaNext(arena, chunkSize);
+    arena->root = arena->current;
+    return arena;
+}
+
+TapkiArena *TapkiArenaAttach(TapkiArena *shared)
+{
+    __TapkiPool* pool = shared->pool;
+    if (TAPKI_UNLIKELY(!pool)) TapkiDie("arena.attach: arena is not shared");
+    TapkiArena* arena = (TapkiArena*)malloc(sizeof(TapkiArena));
+    if (TAPKI_UNLIKELY(!arena)) TapkiDie("arena.attach");
+    *arena = (TapkiArena){};
+    arena->chunk_size = shared->chunk_size;
+    arena->max_chunk_size = shared->chunk_size;
+    arena->pool = pool;
+    __TapkiArenaNext(arena, arena->chunk_size);
+    arena->root = arena->current;
+    TapkiArena* head = __tpk_atomic_load(&pool->arenas);
+    do {
+        arena->next_attached = head;
+    } while (!__tpk_atomic_cas(&pool->arenas, &head, arena));
+    return arena;
+}
+
+static void __TapkiPoolFree(__TapkiPool* pool)
+{
+    __tpk_large_release(pool->owner, 0);
+    TapkiArena* arena = pool->arenas;
+    while (arena) {
+        TapkiArena* next = arena->next_attached;
+        __tpk_large_release(arena, 0);
+        free(arena);
+        arena = next;
+    }
+    __TapkiPoolChunk* chunk = pool->chunks;
+    while (chunk) {
+        __TapkiPoolChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(pool);
+}
+
 void TapkiArenaFree(TapkiArena* arena)
 {
+    if (arena->pool) {
+        if (TAPKI_UNLIKELY(arena->pool->owner != arena))
+            TapkiDie("arena.free: attached arenas are freed together with their shared arena");
+        __TapkiPoolFree(arena->pool);
+        free(arena);
+        return;
+    }
+    __tpk_large_release(arena, 0);
     __TapkiChunk* curr = arena->root;
     while(curr) {
         __TapkiChunk* next = curr->next;
-        free(curr);
+        __tpk_chunk_release(curr);
         curr = next;
     }
-    free(arena);
+    __tpk_arena_struct_release(arena);
 }
 
 void* __tapki_vec_insert(TapkiArena* ar, void* _vec, size_t idx, size_t tsz, size_t al)
@@ -808,8 +2234,8 @@ void* __tapki_vec_insert(TapkiArena* ar, void* _vec, size_t idx, size_t tsz, siz
         char* src = vec->d + idx * tsz;
         char* dest = src + tsz;
         memmove(dest, src, tail * tsz);
-        memset(src, 0, tsz);
     }
+    memset(vec->d + idx * tsz, 0, tsz);
     if (tsz == 1) {
         vec->d[vec->size] = 0;
     }
@@ -818,7 +2244,8 @@ void* __tapki_vec_insert(TapkiArena* ar, void* _vec, size_t idx, size_t tsz, siz
 
 void* __tapki_map_at(TapkiArena *ar, void* _map, const void* key, const __tpk_map_info *info)
 {
-    __TapkiVec* map = (__TapkiVec*)_map;
+    __TapkiMap* map = (__TapkiMap*)_map;
+    map->frozen = NULL;
     char *end = map->d + map->size * info->pair_sizeof;
     char *it = (char*)info->lower_bound(map->d, end, key);
     if (it == end) {
@@ -837,7 +2264,14 @@ void* __tapki_map_at(TapkiArena *ar, void* _map, const void* key, const __tpk_ma
 
 void *__tapki_map_find(const void *_map, const void *key, const __tpk_map_info *info)
 {
-    const __TapkiVec* map = (const __TapkiVec*)_map;
+    const __TapkiMap* map = (const __TapkiMap*)_map;
+    if (map->frozen) {
+        size_t k = info->frozen_lower_bound(map->frozen, map->size, key);
+        if (k && info->eq(map->frozen + k * info->key_sizeof, key)) {
+            return map->d + map->frozen_idx[k] * info->pair_sizeof + info->value_offset;
+        }
+        return NULL;
+    }
     char *end = map->d + map->size * info->pair_sizeof;
     char *it = (char*)info->lower_bound(map->d, end, key);
     if (it != end && info->eq(it, key)) {
@@ -849,7 +2283,8 @@ void *__tapki_map_find(const void *_map, const void *key, const __tpk_map_info *
 
 bool __tapki_map_erase(void *_map, const void *key, const __tpk_map_info* info)
 {
-    __TapkiVec* map = (__TapkiVec*)_map;
+    __TapkiMap* map = (__TapkiMap*)_map;
+    map->frozen = NULL;
     char *end = map->d + map->size * info->pair_sizeof;
     char *it = (char*)info->lower_bound(map->d, end, key);
     if (info->eq(it, key)) {
@@ -861,7 +2296,202 @@ bool __tapki_map_erase(void *_map, const void *key, const __tpk_map_info* info)
     }
 }
 
-TapkiMapImplement(TapkiStrMap, TAPKI_STRING_LESS, TAPKI_STRING_EQ);
+void __tapki_map_finalize(TapkiArena *ar, void *_map, const __tpk_map_info* info)
+{
+    __TapkiMap* map = (__TapkiMap*)_map;
+    map->frozen = NULL;
+    size_t n = map->size;
+    size_t psz = (size_t)info->pair_sizeof;
+    if (n < 2) return;
+    // Bottom-up stable merge sort, ping-ponging between map and temp buffer
+    char* src = map->d;
+    char* dst = (char*)TapkiArenaAllocUninit(ar, n * psz, info->pair_align);
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t l = lo, r = mid, out = lo;
+            while (l < mid && r < hi) {
+                if (info->less(src + r * psz, src + l * psz)) {
+                    memcpy(dst + out++ * psz, src + r++ * psz, psz);
+                } else {
+                    memcpy(dst + out++ * psz, src + l++ * psz, psz);
+                }
+            }
+            _TAPKI_MEMCPY(dst + out * psz, src + l * psz, (mid - l) * psz);
+            out += mid - l;
+            _TAPKI_MEMCPY(dst + out * psz, src + r * psz, (hi - r) * psz);
+        }
+        char* tmp = src; src = dst; dst = tmp;
+    }
+    if (src != map->d) {
+        memcpy(map->d, src, n * psz);
+    }
+    // Dedupe: equal keys are adjacent and in insertion order -> keep last
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) {
+        char* it = map->d + i * psz;
+        if (w && info->eq(map->d + (w - 1) * psz, it)) {
+            memcpy(map->d + (w - 1) * psz, it, psz);
+        } else {
+            if (w != i) memcpy(map->d + w * psz, it, psz);
+            w++;
+        }
+    }
+    map->size = w;
+}
+
+static size_t __tapki_map_eytzinger(__TapkiMap* map, size_t i, size_t k, const __tpk_map_info* info)
+{
+    if (k <= map->size) {
+        i = __tapki_map_eytzinger(map, i, 2 * k, info);
+        memcpy(map->frozen + k * info->key_sizeof, map->d + i * info->pair_sizeof, info->key_sizeof);
+        map->frozen_idx[k] = (uint32_t)i++;
+        i = __tapki_map_eytzinger(map, i, 2 * k + 1, info);
+    }
+    return i;
+}
+
+void __tapki_map_freeze(TapkiArena *ar, void *_map, const __tpk_map_info* info)
+{
+    __TapkiMap* map = (__TapkiMap*)_map;
+    if (!info->frozen_lower_bound) return;
+    if (TAPKI_UNLIKELY(map->size >= UINT32_MAX))
+        TapkiDie("map.freeze: too many elements (%zu)", map->size);
+    map->frozen = (char*)TapkiArenaAllocUninit(ar, (map->size + 1) * info->key_sizeof, info->pair_align);
+    map->frozen_idx = (uint32_t*)TapkiArenaAllocUninit(ar, (map->size + 1) * sizeof(uint32_t), _Alignof(uint32_t));
+    __tapki_map_eytzinger(map, 0, 1, info);
+}
+
+TapkiMapImplement2(TapkiStrMap, TAPKI_STRING_LESS, TAPKI_STRING_EQ, 0);
+TapkiMapImplement2(TapkiSStrMap, TAPKI_STRING_LESS, TAPKI_STRING_EQ, 0);
+
+uint64_t __tapki_hash_str(const char* s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 0x100000001b3ULL;
+    }
+    return __tapki_hash_u64(h);
+}
+
+static inline uint32_t __tapki_hashmap_tag(uint64_t h) {
+    uint32_t tag = (uint32_t)(h ^ (h >> 32));
+    return tag ? tag : 1;
+}
+
+static void __tapki_hashmap_grow(TapkiArena *ar, __TapkiHashMap* map, const __tpk_hashmap_info* info)
+{
+    size_t ncap = map->cap ? map->cap * 2 : 8;
+    size_t psz = (size_t)info->pair_sizeof;
+    ar->stats.wasted_vec += map->cap * (sizeof(uint32_t) + psz);
+    uint32_t* hashes = (uint32_t*)TapkiArenaAllocAligned(ar, ncap * sizeof(uint32_t), _Alignof(uint32_t));
+    char* pairs = (char*)TapkiArenaAllocUninit(ar, ncap * psz, info->pair_align);
+    for (size_t i = 0; i < map->cap; ++i) {
+        uint32_t tag = map->hashes[i];
+        if (!tag) continue;
+        size_t j = tag & (ncap - 1);
+        while (hashes[j]) j = (j + 1) & (ncap - 1);
+        hashes[j] = tag;
+        memcpy(pairs + j * psz, map->d + i * psz, psz);
+    }
+    map->d = pairs;
+    map->hashes = hashes;
+    map->cap = ncap;
+}
+
+static size_t __tapki_hashmap_slot(const __TapkiHashMap* map, const void* key, uint32_t tag, const __tpk_hashmap_info* info)
+{
+    size_t mask = map->cap - 1;
+    size_t i = tag & mask;
+    while (map->hashes[i]) {
+        if (map->hashes[i] == tag && info->eq(map->d + i * info->pair_sizeof, key)) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return Tapki_npos;
+}
+
+void* __tapki_hashmap_at(TapkiArena *ar, void* _map, const void* key, const __tpk_hashmap_info* info)
+{
+    __TapkiHashMap* map = (__TapkiHashMap*)_map;
+    uint32_t tag = __tapki_hashmap_tag(info->hash(key));
+    if (map->cap) {
+        size_t found = __tapki_hashmap_slot(map, key, tag, info);
+        if (found != Tapki_npos) {
+            return map->d + found * info->pair_sizeof + info->value_offset;
+        }
+    }
+    // Keep load factor <= 3/4
+    if ((map->size + 1) * 4 > map->cap * 3) {
+        __tapki_hashmap_grow(ar, map, info);
+    }
+    size_t mask = map->cap - 1;
+    size_t i = tag & mask;
+    while (map->hashes[i]) i = (i + 1) & mask;
+    map->hashes[i] = tag;
+    map->size++;
+    char* pair = map->d + i * info->pair_sizeof;
+    memset(pair, 0, info->pair_sizeof);
+    memcpy(pair, key, info->key_sizeof);
+    return pair + info->value_offset;
+}
+
+void* __tapki_hashmap_find(const void* _map, const void* key, const __tpk_hashmap_info* info)
+{
+    const __TapkiHashMap* map = (const __TapkiHashMap*)_map;
+    if (!map->size) return NULL;
+    size_t found = __tapki_hashmap_slot(map, key, __tapki_hashmap_tag(info->hash(key)), info);
+    return found == Tapki_npos ? NULL : map->d + found * info->pair_sizeof + info->value_offset;
+}
+
+bool __tapki_hashmap_erase(void *_map, const void *key, const __tpk_hashmap_info* info)
+{
+    __TapkiHashMap* map = (__TapkiHashMap*)_map;
+    if (!map->size) return false;
+    size_t i = __tapki_hashmap_slot(map, key, __tapki_hashmap_tag(info->hash(key)), info);
+    if (i == Tapki_npos) return false;
+    size_t psz = (size_t)info->pair_sizeof;
+    size_t mask = map->cap - 1;
+    // Backward shift deletion: no tombstones needed
+    for (size_t j = (i + 1) & mask; map->hashes[j]; j = (j + 1) & mask) {
+        size_t home = map->hashes[j] & mask;
+        bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable) {
+            map->hashes[i] = map->hashes[j];
+            memcpy(map->d + i * psz, map->d + j * psz, psz);
+            i = j;
+        }
+    }
+    map->hashes[i] = 0;
+    map->size--;
+    return true;
+}
+
+void* __tapki_hashmap_next(const void *_map, const void *it, size_t pair_sizeof)
+{
+    const __TapkiHashMap* map = (const __TapkiHashMap*)_map;
+    size_t i = it ? (size_t)((const char*)it - map->d) / pair_sizeof + 1 : 0;
+    for (; i < map->cap; ++i) {
+        if (map->hashes[i]) return map->d + i * pair_sizeof;
+    }
+    return NULL;
+}
+
+TapkiHashMapImplement(TapkiStrHashMap, TAPKI_STRING_HASH, TAPKI_STRING_EQ);
+
+TapkiStrKey TapkiStrKeyOf(const char* s)
+{
+    TapkiStrKey key = {0, strlen(s), s};
+    for (size_t i = 0; i < 8 && i < key.len; ++i) {
+        key.prefix |= (uint64_t)(unsigned char)s[i] << (56 - 8 * i);
+    }
+    return key;
+}
+
+TapkiMapImplement(TapkiStrKeyMap, TAPKI_STRKEY_LESS, TAPKI_STRKEY_EQ);
 
 char *__tapki_vec_reserve(TapkiArena *ar, void *_vec, size_t count, size_t tsz, size_t al)
 {
@@ -871,19 +2501,34 @@ char *__tapki_vec_reserve(TapkiArena *ar, void *_vec, size_t count, size_t tsz,
     if (vec->cap <= count) {
         uintptr_t arenaEnd = (uintptr_t)(ar->current->buff + ar->ptr);
         uintptr_t vecEnd = (uintptr_t)(vec->d + vec->cap * tsz);
+        size_t was = vec->cap * tsz;
         size_t ncap = vec->cap * 2;
         vec->cap = (ncap < count ? count : ncap);
         uintptr_t vecNewEnd = (uintptr_t)(vec->d + vec->cap * tsz);
         uintptr_t arenaCap = (uintptr_t)(ar->current->buff + ar->current->cap);
+        // Large vectors live in own blocks: realloc() grows them without abandoning anything
+        if (vec->cap * tsz >= TAPKI_ARENA_LARGE_VEC && al <= 16) {
+            char* newData = __tpk_large_grow(ar, was >= TAPKI_ARENA_LARGE_VEC ? vec->d : NULL, vec->size * tsz, vec->cap * tsz);
+            if (was < TAPKI_ARENA_LARGE_VEC) {
+                _TAPKI_MEMCPY(newData, vec->d, vec->size * tsz);
+                ar->stats.wasted_vec += was;
+            }
+            ar->stats.allocated += vec->cap * tsz - (was < TAPKI_ARENA_LARGE_VEC ? 0 : was);
+            vec->d = newData;
+        }
         // If we can just grow arena (vector is at the end of it) we do not relocate
-        if (arenaEnd == vecEnd && vecNewEnd < arenaCap) {
-            ar->ptr += (uintptr_t)(vecNewEnd - vecEnd);
+        else if (arenaEnd == vecEnd && vecNewEnd < arenaCap) {
+            size_t grow = (size_t)(vecNewEnd - vecEnd);
+            ar->ptr += grow;
+            ar->stats.allocated += grow;
+            ar->stats.in_use += grow;
 #ifdef ASAN_DEFINE_REGION_MACROS
             ASAN_UNPOISON_MEMORY_REGION(vec->d, vec->cap * tsz);
 #endif
         } else {
-            char* newData = (char*)TapkiArenaAllocAligned(ar, vec->cap * tsz, al);
+            char* newData = (char*)TapkiArenaAllocUninit(ar, vec->cap * tsz, al);
             _TAPKI_MEMCPY(newData, vec->d, vec->size * tsz);
+            ar->stats.wasted_vec += (uintptr_t)(vecEnd - (uintptr_t)vec->d);
             vec->d = newData;
         }
         if (tsz == 1 && vec->d)
@@ -892,6 +2537,18 @@ char *__tapki_vec_reserve(TapkiArena *ar, void *_vec, size_t count, size_t tsz,
     return vec->d;
 }
 
+void __tapki_vec_append(TapkiArena* ar, void* _vec, const void* data, size_t count, size_t tsz, size_t al)
+{
+    __TapkiVec* vec = (__TapkiVec*)_vec;
+    const char* was = vec->d;
+    size_t wasCap = vec->cap * tsz;
+    __tapki_vec_reserve(ar, vec, vec->size + count, tsz, al);
+    _TAPKI_MEMCPY(vec->d + vec->size * tsz, __tpk_rebase(data, was, wasCap, vec->d), count * tsz);
+    vec->size += count;
+    if (tsz == 1 && vec->d)
+        vec->d[vec->size] = 0;
+}
+
 bool __tapki_vec_shrink(TapkiArena* ar, void* _vec, size_t tsz)
 {
 #ifdef ASAN_DEFINE_REGION_MACROS
@@ -905,7 +2562,22 @@ bool __tapki_vec_shrink(TapkiArena* ar, void* _vec, size_t tsz)
     if (diff && tsz == 1) {
         diff--;
     }
+    __TapkiLarge** large;
+    if (vec->cap * tsz >= TAPKI_ARENA_LARGE_VEC && (vec->cap - diff) * tsz >= TAPKI_ARENA_LARGE_VEC
+        && (large = __tpk_large_find(ar, vec->d)) != NULL)
+    {
+        __TapkiLarge* block = (__TapkiLarge*)realloc(*large, sizeof(__TapkiLarge) + (vec->cap - diff) * tsz);
+        if (TAPKI_UNLIKELY(!block)) return false;
+        *large = block;
+        block->cap = (vec->cap - diff) * tsz;
+        ar->stats.allocated -= tsz * diff;
+        vec->d = block->buff;
+        vec->cap -= diff;
+        return true;
+    }
     if (arenaEnd == vecEnd) {
+        __tpk_arena_release_to(ar, ar->stats.in_use - tsz * diff);
+        ar->stats.allocated -= tsz * diff;
         ar->ptr -= tsz * diff;
         vec->cap -= diff;
         return true;
@@ -927,24 +2599,246 @@ char *__tapki_vec_resize(TapkiArena *ar, void *_vec, size_t count, size_t tsz, s
 }
 
 
-TapkiStr* TapkiStrAppendVF(TapkiArena *ar, TapkiStr *str, const char *fmt, va_list list)
+static char* __tpk_u64_digits(char* end, uint64_t v)
 {
-    va_list list2;
-    va_copy(list2, list);
-    char buff[200];
-    const size_t cap = sizeof(buff);
-    size_t count = vsnprintf(buff, cap, fmt, list);
-    if (count) {
-        size_t was = str->size;
-        TapkiVecReserve(ar, str, str->size + count);
-        if (count < cap) {
-            if (count)
-                memcpy(str->d + was, buff, count + 1);
-        } else {
-            vsnprintf(str->d + was, str->cap, fmt, list2);
-        }
-        str->size += count;
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    while (v >= 100) {
+        end -= 2;
+        memcpy(end, pairs + (v % 100) * 2, 2);
+        v /= 100;
     }
+    if (v >= 10) {
+        end -= 2;
+        memcpy(end, pairs + v * 2, 2);
+    } else {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
+
+static TapkiStr* __tpk_append_i64(TapkiArena *ar, TapkiStr *str, uint64_t mag, bool neg)
+{
+    char buff[21];
+    char* end = buff + sizeof(buff);
+    char* it = __tpk_u64_digits(end, mag);
+    if (neg) *--it = '-';
+    __tapki_vec_append(ar, str, it, (size_t)(end - it), 1, 1);
+    return str;
+}
+
+TapkiStr* TapkiStrAppendI64(TapkiArena *ar, TapkiStr *str, int64_t v)
+{
+    return __tpk_append_i64(ar, str, v < 0 ? 0 - (uint64_t)v : (uint64_t)v, v < 0);
+}
+
+TapkiStr* TapkiStrAppendU64(TapkiArena *ar, TapkiStr *str, uint64_t v)
+{
+    return __tpk_append_i64(ar, str, v, false);
+}
+
+TapkiStr* TapkiStrAppendDouble(TapkiArena *ar, TapkiStr *str, double v)
+{
+    // Integral values up to 2^53 (except -0.0) are printed as plain integers, without
+    // exponent unlike %g: 1e15 -> "1000000000000000"
+    if (v >= -9007199254740992.0 && v <= 9007199254740992.0 && (v != 0 || 1 / v > 0) && (double)(int64_t)v == v) {
+        return TapkiStrAppendI64(ar, str, (int64_t)v);
+    }
+    char buff[32];
+    int count = 0;
+    // Subnormals have less precision: even 15 digits can be too many
+    bool subnormal = v > -2.2250738585072014e-308 && v < 2.2250738585072014e-308;
+    for (int prec = subnormal ? 1 : 15; prec <= 17; ++prec) {
+        count = snprintf(buff, sizeof(buff), "%.*g", prec, v);
+        if (prec == 17 || strtod(buff, NULL) == v) break;
+    }
+    __tapki_vec_append(ar, str, buff, (size_t)count, 1, 1);
+    return str;
+}
+
+// Fast path for formats with plain %s %c %d %i %u (+ l, ll, z) and %% only:
+// no printf parsing, integers are converted with __tpk_u64_digits()
+static bool __tpk_fmt_simple(TapkiArena *ar, TapkiStr *str, const char *fmt, va_list list)
+{
+    for (const char* it = strchr(fmt, '%'); it; it = strchr(it + 1, '%')) {
+        it++;
+        if (*it == 'l') it += it[1] == 'l' ? 2 : 1;
+        else if (*it == 'z') it++;
+        if (!*it || !strchr("sciud%", *it)) return false;
+        if ((*it == 's' || *it == 'c' || *it == '%') && it[-1] != '%') return false;
+    }
+    // %s argument may point into str itself: its length is bounded by the original terminator
+    const char* self = str->d;
+    size_t selfSize = str->size;
+    while (*fmt) {
+        const char* pct = strchr(fmt, '%');
+        size_t lit = pct ? (size_t)(pct - fmt) : strlen(fmt);
+        __tapki_vec_append(ar, str, fmt, lit, 1, 1);
+        if (!pct) break;
+        const char* spec = pct + 1;
+        int lng = 0;
+        if (*spec == 'l') lng = spec[1] == 'l' ? 2 : 1;
+        else if (*spec == 'z') lng = 3;
+        spec += lng == 2 ? 2 : lng ? 1 : 0;
+        switch (*spec) {
+        case 's': {
+            const char* arg = va_arg(list, const char*);
+            if (!arg) arg = "(null)";
+            uintptr_t off = (uintptr_t)arg - (uintptr_t)self;
+            size_t len;
+            if (self && off <= selfSize) {
+                arg = str->d + off; // earlier pieces may have moved a large string
+                len = strnlen(arg, selfSize - off);
+            } else {
+                len = strlen(arg);
+            }
+            __tapki_vec_append(ar, str, arg, len, 1, 1);
+            break;
+        }
+        case 'c': {
+            char c = (char)va_arg(list, int);
+            __tapki_vec_append(ar, str, &c, 1, 1, 1);
+            break;
+        }
+        case '%':
+            __tapki_vec_append(ar, str, "%", 1, 1, 1);
+            break;
+        case 'u': {
+            uint64_t v = lng == 0 ? va_arg(list, unsigned) : lng == 1 ? va_arg(list, unsigned long)
+                : lng == 2 ? va_arg(list, unsigned long long) : va_arg(list, size_t);
+            TapkiStrAppendU64(ar, str, v);
+            break;
+        }
+        default: {
+            int64_t v = lng == 0 ? va_arg(list, int) : lng == 1 ? va_arg(list, long)
+                : lng == 2 ? va_arg(list, long long) : va_arg(list, ptrdiff_t);
+            TapkiStrAppendI64(ar, str, v);
+            break;
+        }
+        }
+        fmt = spec + 1;
+    }
+    return true;
+}
+
+// Writable space after str->size. If string ends at arena tail (or is empty), rest of
+// current chunk is usable too: used part is then claimed by __tpk_str_commit().
+// Under ASAN free tail is unpoisoned here and poisoned back by __tpk_str_done().
+static size_t __tpk_str_room(TapkiArena *ar, TapkiStr *str, char** out)
+{
+    char* tail = ar->current->buff + ar->ptr;
+    if (!str->d || str->d + str->cap == tail) {
+        *out = str->d ? str->d + str->size : tail;
+        size_t room = (size_t)(ar->current->buff + ar->current->cap - *out);
+#ifdef ASAN_DEFINE_REGION_MACROS
+        ASAN_UNPOISON_MEMORY_REGION(*out, room);
+#endif
+        return room;
+    }
+    *out = str->d + str->size;
+    return str->cap - str->size;
+}
+
+static void __tpk_str_done(TapkiArena *ar)
+{
+#ifdef ASAN_DEFINE_REGION_MACROS
+    ASAN_POISON_MEMORY_REGION(ar->current->buff + ar->ptr, ar->current->cap - ar->ptr);
+#else
+    (void)ar;
+#endif
+}
+
+static void __tpk_str_commit(TapkiArena *ar, TapkiStr *str, char* out, size_t count)
+{
+    if (!str->d) str->d = out;
+    char* end = out + count + 1;
+    char* capEnd = str->d + str->cap;
+    if (end > capEnd) {
+        size_t grow = (size_t)(end - capEnd);
+        ar->ptr += grow;
+        ar->stats.allocated += grow;
+        ar->stats.in_use += grow;
+        str->cap += grow;
+    }
+    str->size += count;
+}
+
+// Whether a pointer argument (%s, %p) points into [d, d + cap): formatting straight into the
+// string would overwrite it. Formats that cannot be captured are assumed to alias
+static bool __tpk_fmt_aliases(const char* fmt, va_list list, const char* d, size_t cap)
+{
+    if (!d) return false;
+    __tpk_scope scope;
+    if (!__tpk_frame_capture(&scope, fmt, list)) return true;
+    uintptr_t lo = (uintptr_t)d, hi = lo + cap;
+    size_t n = 0;
+    for (const char* it = strchr(fmt, '%'); it; it = strchr(it, '%')) {
+        __tpk_fmt_spec spec;
+        it = __tpk_fmt_spec_parse(it + 1, &spec);
+        int kind = __tpk_fmt_spec_kind(&spec);
+        if (kind == __TPK_ARG_NONE) continue;
+        n += (spec.nwidth && *spec.width == '*') + (spec.nprec && *spec.prec == '*');
+        uintptr_t p = (uintptr_t)scope.data.args[n++].p;
+        if (kind == __TPK_ARG_PTR && p >= lo && p < hi) return true;
+    }
+    return false;
+}
+
+// Arguments alias the string: format on the side (stack, heap if long), then append
+static void __tpk_append_vf_copy(TapkiArena *ar, TapkiStr *str, const char *fmt, va_list list)
+{
+    va_list list2;
+    va_copy(list2, list);
+    char small[256];
+    int res = vsnprintf(small, sizeof(small), fmt, list);
+    if (TAPKI_UNLIKELY(res < 0)) TapkiDie("str.format: invalid format: %s", fmt);
+    char* buff = small;
+    if ((size_t)res >= sizeof(small)) {
+        buff = (char*)malloc((size_t)res + 1);
+        if (TAPKI_UNLIKELY(!buff)) TapkiDie("str.format: out of memory");
+        vsnprintf(buff, (size_t)res + 1, fmt, list2);
+    }
+    va_end(list2);
+    __tapki_vec_append(ar, str, buff, (size_t)res, 1, 1);
+    if (buff != small) free(buff);
+}
+
+// Formats in place: second vsnprintf() is only needed if output does not fit into current chunk
+TapkiStr* TapkiStrAppendVF(TapkiArena *ar, TapkiStr *str, const char *fmt, va_list list)
+{
+    if (__tpk_fmt_simple(ar, str, fmt, list)) {
+        return str;
+    }
+    va_list check;
+    va_copy(check, list);
+    bool aliases = __tpk_fmt_aliases(fmt, check, str->d, str->cap);
+    va_end(check);
+    if (TAPKI_UNLIKELY(aliases)) {
+        __tpk_append_vf_copy(ar, str, fmt, list);
+        return str;
+    }
+    va_list list2;
+    va_copy(list2, list);
+    char* out;
+    size_t room = __tpk_str_room(ar, str, &out);
+    if (room < 64) {
+        __tpk_str_done(ar);
+        TapkiVecReserve(ar, str, str->size + 64);
+        room = __tpk_str_room(ar, str, &out);
+    }
+    int res = vsnprintf(out, room, fmt, list);
+    if (TAPKI_UNLIKELY(res < 0)) TapkiDie("str.format: invalid format: %s", fmt);
+    size_t count = (size_t)res;
+    if (count < room) {
+        __tpk_str_commit(ar, str, out, count);
+    } else {
+        TapkiVecReserve(ar, str, str->size + count);
+        vsnprintf(str->d + str->size, count + 1, fmt, list2);
+        str->size += count;
+    }
+    __tpk_str_done(ar);
     va_end(list2);
     return str;
 }
@@ -982,6 +2876,250 @@ TapkiStr TapkiS(TapkiArena *ar, const char *s)
     return result;
 }
 
+// Transitions to states with output have this bit set
+#define __TPK_AC_OUT 0x80000000u
+#define __TPK_AC_NONE 0xFFFFFFFFu
+
+// States are identified by their row offset in delta (state * ncls), so stepping is a single load
+struct TapkiMatcher {
+    uint32_t* delta; // [state * ncls + class] -> next row (| __TPK_AC_OUT)
+    uint32_t* own; // [state] needle ending exactly in state
+    uint32_t* outlink; // [state] nearest state on failure chain with own needle
+    size_t* lens;
+    size_t ncls;
+    int first; // if all needles start with same byte: memchr() to it while in root
+    uint16_t cls[256];
+};
+
+TapkiMatcher* TapkiMatcherCreate(TapkiArena* ar, const char* const* needles, size_t count)
+{
+    TapkiMatcher* m = (TapkiMatcher*)TapkiArenaAlloc(ar, sizeof(TapkiMatcher));
+    m->lens = (size_t*)TapkiArenaAllocUninit(ar, sizeof(size_t) * count, _Alignof(size_t));
+    size_t ncls = 1;
+    m->first = -1;
+    for (size_t i = 0; i < count; ++i) {
+        m->lens[i] = strlen(needles[i]);
+        if (m->lens[i]) {
+            int first = (uint8_t)needles[i][0];
+            m->first = m->first == -1 || m->first == first ? first : -2;
+        }
+        for (size_t j = 0; j < m->lens[i]; ++j) {
+            uint8_t b = (uint8_t)needles[i][j];
+            if (!m->cls[b]) m->cls[b] = (uint16_t)ncls++;
+        }
+    }
+    m->ncls = ncls;
+    TapkiVec(uint32_t) delta = {0};
+    TapkiVec(uint32_t) own = {0};
+    TapkiVecResize(ar, &delta, ncls);
+    *TapkiVecPush(ar, &own) = __TPK_AC_NONE;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t st = 0;
+        if (!m->lens[i]) continue;
+        for (size_t j = 0; j < m->lens[i]; ++j) {
+            size_t edge = st * ncls + m->cls[(uint8_t)needles[i][j]];
+            if (!delta.d[edge]) {
+                if (TAPKI_UNLIKELY((own.size + 1) * ncls >= __TPK_AC_OUT))
+                    TapkiDie("matcher: too many states");
+                delta.d[edge] = (uint32_t)own.size;
+                TapkiVecResize(ar, &delta, delta.size + ncls);
+                *TapkiVecPush(ar, &own) = __TPK_AC_NONE;
+            }
+            st = delta.d[edge];
+        }
+        if (own.d[st] == __TPK_AC_NONE) own.d[st] = (uint32_t)i;
+    }
+    // BFS: failure links, missing edges are replaced with ones of failure state
+    size_t nstates = own.size;
+    uint32_t* fail = (uint32_t*)TapkiArenaAllocUninit(ar, sizeof(uint32_t) * nstates, _Alignof(uint32_t));
+    uint32_t* outlink = (uint32_t*)TapkiArenaAllocUninit(ar, sizeof(uint32_t) * nstates, _Alignof(uint32_t));
+    uint32_t* queue = (uint32_t*)TapkiArenaAllocUninit(ar, sizeof(uint32_t) * nstates, _Alignof(uint32_t));
+    size_t head = 0, tail = 0;
+    fail[0] = 0;
+    outlink[0] = __TPK_AC_NONE;
+    for (size_t c = 0; c < ncls; ++c) {
+        uint32_t s = delta.d[c];
+        if (s) {
+            fail[s] = 0;
+            outlink[s] = __TPK_AC_NONE;
+            queue[tail++] = s;
+        }
+    }
+    while (head < tail) {
+        uint32_t r = queue[head++];
+        for (size_t c = 0; c < ncls; ++c) {
+            uint32_t s = delta.d[r * ncls + c];
+            uint32_t f = delta.d[fail[r] * ncls + c];
+            if (s) {
+                fail[s] = f;
+                outlink[s] = own.d[f] != __TPK_AC_NONE ? f : outlink[f];
+                queue[tail++] = s;
+            } else {
+                delta.d[r * ncls + c] = f;
+            }
+        }
+    }
+    for (size_t i = 0; i < delta.size; ++i) {
+        uint32_t s = delta.d[i];
+        delta.d[i] = (uint32_t)(s * ncls);
+        if (own.d[s] != __TPK_AC_NONE || outlink[s] != __TPK_AC_NONE) delta.d[i] |= __TPK_AC_OUT;
+    }
+    m->delta = delta.d;
+    m->own = own.d;
+    m->outlink = outlink;
+    return m;
+}
+
+// Skips to next possible match start while in root state
+static inline size_t __tpk_matcher_skip(const TapkiMatcher* m, TapkiStrView s, size_t i, uint32_t st)
+{
+    if (st || m->first < 0) return i;
+    const char* next = (const char*)memchr(s.d + i, m->first, s.size - i);
+    return next ? (size_t)(next - s.d) : s.size;
+}
+
+size_t TapkiMatcherFind(const TapkiMatcher* m, TapkiStrView s, size_t offset, size_t* needle)
+{
+    uint32_t st = 0;
+    for (size_t i = offset; (i = __tpk_matcher_skip(m, s, i, st)) < s.size; ++i) {
+        st = m->delta[(st & ~__TPK_AC_OUT) + m->cls[(uint8_t)s.d[i]]];
+        if (TAPKI_UNLIKELY(st & __TPK_AC_OUT)) {
+            st = (st & ~__TPK_AC_OUT) / (uint32_t)m->ncls;
+            uint32_t idx = m->own[st] != __TPK_AC_NONE ? m->own[st] : m->own[m->outlink[st]];
+            if (needle) *needle = idx;
+            return i + 1 - m->lens[idx];
+        }
+    }
+    return Tapki_npos;
+}
+
+TapkiMatchVec TapkiMatcherFindAll(TapkiArena* ar, const TapkiMatcher* m, TapkiStrView s)
+{
+    TapkiMatchVec result = {0};
+    uint32_t st = 0;
+    for (size_t i = 0; (i = __tpk_matcher_skip(m, s, i, st)) < s.size; ++i) {
+        st = m->delta[(st & ~__TPK_AC_OUT) + m->cls[(uint8_t)s.d[i]]];
+        if (TAPKI_UNLIKELY(st & __TPK_AC_OUT)) {
+            uint32_t it = (st & ~__TPK_AC_OUT) / (uint32_t)m->ncls;
+            if (m->own[it] == __TPK_AC_NONE) it = m->outlink[it];
+            for (; it != __TPK_AC_NONE; it = m->outlink[it]) {
+                uint32_t idx = m->own[it];
+                *TapkiVecPush(ar, &result) = (TapkiMatch){i + 1 - m->lens[idx], idx};
+            }
+        }
+    }
+    return result;
+}
+
+// Returns string in arena with room for at least res chars, converting inline one if needed
+static TapkiStr __tpk_sstr_heap(TapkiArena* ar, const TapkiSStr* s, size_t res)
+{
+    TapkiStr str = {0};
+    if (TapkiSStrIsInline(s)) {
+        TapkiVecReserve(ar, &str, res + 1);
+        _TAPKI_MEMCPY(str.d, s->sso.d, s->sso.tag + 1);
+        str.size = s->sso.tag;
+    } else {
+        str = (TapkiStr){s->heap.d, s->heap.size, s->heap.cap};
+        TapkiVecReserve(ar, &str, res + 1);
+    }
+    return str;
+}
+
+static void __tpk_sstr_store(TapkiSStr* s, TapkiStr str)
+{
+    if (TAPKI_UNLIKELY(str.cap > UINT32_MAX))
+        TapkiDie("sstr: too big (%zu)", str.size);
+    s->heap.d = str.d;
+    s->heap.size = (uint32_t)str.size;
+    s->heap.cap = (uint32_t)str.cap;
+    s->heap.tag = TAPKI_SSTR_HEAP;
+}
+
+TapkiSStr TapkiSStrCopy(TapkiArena* ar, const char* target, size_t len)
+{
+    TapkiSStr res;
+    if (len <= TAPKI_SSTR_INLINE) {
+        _TAPKI_MEMCPY(res.sso.d, target, len);
+        res.sso.d[len] = 0;
+        res.sso.tag = (uint8_t)len;
+    } else {
+        __tpk_sstr_store(&res, TapkiStrCopy(ar, target, len));
+    }
+    return res;
+}
+
+TapkiSStr TapkiSS(TapkiArena* ar, const char* s)
+{
+    return TapkiSStrCopy(ar, s, strlen(s));
+}
+
+TapkiSStr* __tapkiss_append(TapkiArena *ar, TapkiSStr *target, const char** strs, size_t count)
+{
+    size_t was = TapkiSStrSize(target);
+    size_t total = was;
+    size_t* lens = __tpk_alloca(sizeof(size_t) * count);
+    for (size_t i = 0; i < count; ++i) {
+        total += (lens[i] = strlen(strs[i]));
+    }
+    if (TapkiSStrIsInline(target) && total <= TAPKI_SSTR_INLINE) {
+        for (size_t i = 0; i < count; ++i) {
+            _TAPKI_MEMCPY(target->sso.d + was, strs[i], lens[i]);
+            was += lens[i];
+        }
+        target->sso.d[total] = 0;
+        target->sso.tag = (uint8_t)total;
+        return target;
+    }
+    // Sources may point into target: inline bytes stay intact until the final store,
+    // heap ones are rebased if the buffer moved
+    const char* old = TapkiSStrIsInline(target) ? NULL : target->heap.d;
+    size_t oldCap = TapkiSStrIsInline(target) ? 0 : target->heap.cap;
+    TapkiStr str = __tpk_sstr_heap(ar, target, total);
+    for (size_t i = 0; i < count; ++i) {
+        _TAPKI_MEMCPY(str.d + was, __tpk_rebase(strs[i], old, oldCap, str.d), lens[i]);
+        was += lens[i];
+    }
+    str.d[total] = 0;
+    str.size = total;
+    __tpk_sstr_store(target, str);
+    return target;
+}
+
+TapkiSStr* TapkiSStrAppendVF(TapkiArena *ar, TapkiSStr *str, const char *fmt, va_list list)
+{
+    va_list check;
+    va_copy(check, list);
+    // Arguments pointing into inline buffer: format on the heap, inline bytes stay intact till store
+    bool aliases = TapkiSStrIsInline(str) && __tpk_fmt_aliases(fmt, check, str->sso.d, sizeof(str->sso.d));
+    va_end(check);
+    if (TapkiSStrIsInline(str) && !aliases) {
+        va_list list2;
+        va_copy(list2, list);
+        size_t was = str->sso.tag;
+        size_t count = (size_t)vsnprintf(str->sso.d + was, TAPKI_SSTR_INLINE + 1 - was, fmt, list2);
+        va_end(list2);
+        if (was + count <= TAPKI_SSTR_INLINE) {
+            str->sso.tag = (uint8_t)(was + count);
+            return str;
+        }
+        str->sso.d[was] = 0;
+    }
+    TapkiStr heap = __tpk_sstr_heap(ar, str, TapkiSStrSize(str));
+    TapkiStrAppendVF(ar, &heap, fmt, list);
+    __tpk_sstr_store(str, heap);
+    return str;
+}
+
+TapkiSStr* TapkiSStrAppendF(TapkiArena *ar, TapkiSStr *str, const char *fmt, ...)
+{
+    va_list vargs;
+    va_start(vargs, fmt);
+    TapkiSStrAppendVF(ar, str, fmt, vargs);
+    va_end(vargs);
+    return str;
+}
+
 static FILE* __tpk_open(const char* file, const char* mode, const char* action) {
     FILE* f = fopen(file, mode);
     if (!f) {
@@ -1004,52 +3142,304 @@ void TapkiFileAppend(const char *file, const char *contents)
     fclose(f);
 }
 
-double TapkiToFloat(const char *s)
+const char* TapkiParseErrStr(TapkiParseErr err)
+{
+    switch (err) {
+    case TAPKI_PARSE_OK: return "ok";
+    case TAPKI_PARSE_EMPTY: return "no digits";
+    case TAPKI_PARSE_INVALID: return "invalid character";
+    case TAPKI_PARSE_RANGE: return "out of range";
+    }
+    return "unknown";
+}
+
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define __TPK_SWAR_DIGITS
+// 8 ascii digits (little-endian load) at once
+static inline bool __tpk_is_8digits(uint64_t v)
+{
+    return (((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+        == 0x3333333333333333ull);
+}
+
+static inline uint64_t __tpk_parse_8digits(uint64_t v)
+{
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)))
+        + (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    return v;
+}
+#endif
+
+// Parses decimal digits (as many as there are). Returns count of digits consumed
+static size_t __tpk_parse_digits(const char* p, size_t n, uint64_t* out, bool* overflow)
+{
+    uint64_t v = 0;
+    size_t i = 0;
+#ifdef __TPK_SWAR_DIGITS
+    // 16 digits can not overflow
+    while (i < 16 && n - i >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, p + i, 8);
+        if (!__tpk_is_8digits(chunk)) break;
+        v = v * 100000000 + __tpk_parse_8digits(chunk);
+        i += 8;
+    }
+#endif
+    for (; i < n && (unsigned char)(p[i] - '0') < 10; ++i) {
+        uint64_t d = (uint64_t)(p[i] - '0');
+        if (TAPKI_UNLIKELY(v > (UINT64_MAX - d) / 10)) *overflow = true;
+        v = v * 10 + d;
+    }
+    *out = v;
+    return i;
+}
+
+// Shared by integer parsers: sign + magnitude, consumes until first non-digit
+static TapkiParseErr __tpk_parse_int(const char* p, size_t n, bool allowMinus, bool* neg, uint64_t* mag, size_t* used)
+{
+    size_t i = 0;
+    *neg = false;
+    if (i < n && (p[i] == '-' || p[i] == '+')) {
+        *neg = p[i] == '-';
+        if (*neg && !allowMinus) return TAPKI_PARSE_INVALID;
+        i++;
+    }
+    bool overflow = false;
+    size_t digits = __tpk_parse_digits(p + i, n - i, mag, &overflow);
+    *used = i + digits;
+    if (!digits) return i < n ? TAPKI_PARSE_INVALID : TAPKI_PARSE_EMPTY;
+    return overflow ? TAPKI_PARSE_RANGE : TAPKI_PARSE_OK;
+}
+
+static TapkiParseErr __tpk_parse_signed(TapkiStrView s, int64_t min, int64_t max, int64_t* out)
+{
+    bool neg;
+    uint64_t mag;
+    size_t used;
+    TapkiParseErr err = __tpk_parse_int(s.d, s.size, true, &neg, &mag, &used);
+    if (err == TAPKI_PARSE_OK && used != s.size) err = TAPKI_PARSE_INVALID;
+    if (err) return err;
+    if (neg ? mag > 0 - (uint64_t)min : mag > (uint64_t)max) return TAPKI_PARSE_RANGE;
+    *out = neg ? (int64_t)(0 - mag) : (int64_t)mag;
+    return TAPKI_PARSE_OK;
+}
+
+static TapkiParseErr __tpk_parse_unsigned(TapkiStrView s, uint64_t max, uint64_t* out)
+{
+    bool neg;
+    uint64_t mag;
+    size_t used;
+    TapkiParseErr err = __tpk_parse_int(s.d, s.size, false, &neg, &mag, &used);
+    if (err == TAPKI_PARSE_OK && used != s.size) err = TAPKI_PARSE_INVALID;
+    if (err) return err;
+    if (mag > max) return TAPKI_PARSE_RANGE;
+    *out = mag;
+    return TAPKI_PARSE_OK;
+}
+
+TapkiParseErr TapkiParseI64(TapkiStrView s, int64_t* out)
+{
+    return __tpk_parse_signed(s, INT64_MIN, INT64_MAX, out);
+}
+
+TapkiParseErr TapkiParseI32(TapkiStrView s, int32_t* out)
+{
+    int64_t v;
+    TapkiParseErr err = __tpk_parse_signed(s, INT32_MIN, INT32_MAX, &v);
+    if (!err) *out = (int32_t)v;
+    return err;
+}
+
+TapkiParseErr TapkiParseU64(TapkiStrView s, uint64_t* out)
+{
+    return __tpk_parse_unsigned(s, UINT64_MAX, out);
+}
+
+TapkiParseErr TapkiParseU32(TapkiStrView s, uint32_t* out)
+{
+    uint64_t v;
+    TapkiParseErr err = __tpk_parse_unsigned(s, UINT32_MAX, &v);
+    if (!err) *out = (uint32_t)v;
+    return err;
+}
+
+// Slow path: strtod() on a terminated copy. Reached for mantissas above 2^53, |exp10| > 22
+// and inf/nan. Syntax is already validated by the caller, so the only locale-dependent part
+// is the decimal point: '.' is replaced with the one of current locale (may be multibyte).
+static TapkiParseErr __tpk_parse_double_slow(TapkiStrView s, double* out)
 {
+    const char* point = localeconv()->decimal_point;
+    if (!point || !*point) point = ".";
+    size_t plen = strlen(point);
+    char small[64];
+    size_t need = s.size + plen;
+    char* copy = need < sizeof(small) ? small : (char*)malloc(need);
+    if (!copy) TapkiDie("parse.double: out of memory");
+    size_t len = 0;
+    for (size_t i = 0; i < s.size; ++i) {
+        if (s.d[i] == '.') {
+            memcpy(copy + len, point, plen);
+            len += plen;
+        } else {
+            copy[len++] = s.d[i];
+        }
+    }
+    copy[len] = 0;
     char* end;
-    double res = strtod(s, &end);
-    if (TAPKI_UNLIKELY(*end != 0)) {
-        TapkiDie("Could fully not convert to double: %s", s);
+    errno = 0;
+    double v = strtod(copy, &end);
+    TapkiParseErr err = TAPKI_PARSE_OK;
+    if (end != copy + len) err = TAPKI_PARSE_INVALID;
+    else if (errno == ERANGE && (v > 1 || v < -1)) err = TAPKI_PARSE_RANGE;
+    if (copy != small) free(copy);
+    if (!err) *out = v;
+    return err;
+}
+
+// Clinger's fast path: mantissa and power of 10 are both exact doubles -> one rounding
+TapkiParseErr TapkiParseDouble(TapkiStrView s, double* out)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    const char* p = s.d;
+    size_t n = s.size, i = 0;
+    if (!n) return TAPKI_PARSE_EMPTY;
+    bool neg = false;
+    if (p[i] == '-' || p[i] == '+') neg = p[i++] == '-';
+    bool overflow = false;
+    uint64_t mant = 0;
+    size_t intDigits = __tpk_parse_digits(p + i, n - i, &mant, &overflow);
+    i += intDigits;
+    size_t fracDigits = 0;
+    if (i < n && p[i] == '.') {
+        i++;
+        const char* fracStart = p + i;
+        // Fraction continues same mantissa
+        for (; i < n && (unsigned char)(p[i] - '0') < 10; ++i) {
+            uint64_t d = (uint64_t)(p[i] - '0');
+            if (mant > (UINT64_MAX - d) / 10) overflow = true;
+            mant = mant * 10 + d;
+        }
+        fracDigits = (size_t)(p + i - fracStart);
+    }
+    if (!intDigits && !fracDigits) {
+        if (i < n && (p[i] == 'i' || p[i] == 'I' || p[i] == 'n' || p[i] == 'N')) {
+            return __tpk_parse_double_slow(s, out);
+        }
+        return i < n ? TAPKI_PARSE_INVALID : TAPKI_PARSE_EMPTY;
+    }
+    int64_t exp10 = 0;
+    if (i < n && (p[i] == 'e' || p[i] == 'E')) {
+        i++;
+        bool eneg = false;
+        if (i < n && (p[i] == '-' || p[i] == '+')) eneg = p[i++] == '-';
+        uint64_t e = 0;
+        bool eoverflow = false;
+        size_t edigits = __tpk_parse_digits(p + i, n - i, &e, &eoverflow);
+        if (!edigits) return TAPKI_PARSE_INVALID;
+        i += edigits;
+        if (eoverflow || e > 100000) return __tpk_parse_double_slow(s, out);
+        exp10 = eneg ? -(int64_t)e : (int64_t)e;
+    }
+    if (i != n) return TAPKI_PARSE_INVALID;
+    exp10 -= (int64_t)fracDigits;
+    if (overflow || mant > (1ull << 53) || exp10 < -22 || exp10 > 22) {
+        return __tpk_parse_double_slow(s, out);
+    }
+    double v = (double)mant;
+    v = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+    *out = neg ? -v : v;
+    return TAPKI_PARSE_OK;
+}
+
+TapkiParseErr TapkiParseI64Bulk(TapkiArena* ar, TapkiStrView s, char delim, TapkiIntVec* out, size_t* bad)
+{
+    size_t i = 0;
+    int64_t* it = out->d + out->size;
+    int64_t* end = out->d + out->cap;
+    while (i < s.size) {
+        bool neg;
+        uint64_t mag;
+        size_t used;
+        TapkiParseErr err = __tpk_parse_int(s.d + i, s.size - i, true, &neg, &mag, &used);
+        if (!err && i + used < s.size && s.d[i + used] != delim) {
+            err = TAPKI_PARSE_INVALID;
+        }
+        if (!err && (neg ? mag > (uint64_t)INT64_MAX + 1 : mag > (uint64_t)INT64_MAX)) {
+            err = TAPKI_PARSE_RANGE;
+        }
+        if (TAPKI_UNLIKELY(err)) {
+            if (err == TAPKI_PARSE_INVALID && !used && s.d[i] == delim) err = TAPKI_PARSE_EMPTY;
+            if (bad) *bad = i;
+            out->size = (size_t)(it - out->d);
+            return err;
+        }
+        if (TAPKI_UNLIKELY(it == end)) {
+            out->size = (size_t)(it - out->d);
+            // Guess count by length of field just parsed
+            TapkiVecReserve(ar, out, out->size + (s.size - i) / (used + 1) + 1);
+            it = out->d + out->size;
+            end = out->d + out->cap;
+        }
+        *it++ = neg ? (int64_t)(0 - mag) : (int64_t)mag;
+        i += used + 1;
+    }
+    out->size = (size_t)(it - out->d);
+    return TAPKI_PARSE_OK;
+}
+
+double TapkiToFloat(const char *s)
+{
+    double res;
+    TapkiParseErr err = TapkiParseDouble(TapkiSV_Of(s), &res);
+    if (TAPKI_UNLIKELY(err)) {
+        TapkiDie("Could not convert to double: %s (%s)", s, TapkiParseErrStr(err));
     }
     return res;
 }
 
 uint64_t TapkiToU64(const char *s)
 {
-    char* end;
-    uint64_t res = strtoull(s, &end, 10);
-    if (TAPKI_UNLIKELY(*end != 0)) {
-        TapkiDie("Could fully not convert to UInt64: %s", s);
+    uint64_t res;
+    TapkiParseErr err = TapkiParseU64(TapkiSV_Of(s), &res);
+    if (TAPKI_UNLIKELY(err)) {
+        TapkiDie("Could not convert to UInt64: %s (%s)", s, TapkiParseErrStr(err));
     }
     return res;
 }
 
 int64_t TapkiToI64(const char *s)
 {
-    char* end;
-    int64_t res = strtoll(s, &end, 10);
-    if (TAPKI_UNLIKELY(*end != 0)) {
-        TapkiDie("Could fully not convert to Int64: %s", s);
+    int64_t res;
+    TapkiParseErr err = TapkiParseI64(TapkiSV_Of(s), &res);
+    if (TAPKI_UNLIKELY(err)) {
+        TapkiDie("Could not convert to Int64: %s (%s)", s, TapkiParseErrStr(err));
     }
     return res;
 }
 
 uint32_t TapkiToU32(const char *s)
 {
-    uint64_t res = TapkiToI64(s);
-    if (TAPKI_UNLIKELY(res > UINT32_MAX)) {
-        TapkiDie("Integer is too big for UInt32: %s", s);
+    uint32_t res;
+    TapkiParseErr err = TapkiParseU32(TapkiSV_Of(s), &res);
+    if (TAPKI_UNLIKELY(err)) {
+        TapkiDie("Could not convert to UInt32: %s (%s)", s, TapkiParseErrStr(err));
     }
-    return (uint32_t)res;
+    return res;
 }
 
 int32_t TapkiToI32(const char *s)
 {
-    int64_t res = TapkiToI64(s);
-    if (TAPKI_UNLIKELY(res > INT32_MAX)) {
-        TapkiDie("Integer is too big for Int32: %s", s);
+    int32_t res;
+    TapkiParseErr err = TapkiParseI32(TapkiSV_Of(s), &res);
+    if (TAPKI_UNLIKELY(err)) {
+        TapkiDie("Could not convert to Int32: %s (%s)", s, TapkiParseErrStr(err));
     }
-    return (int32_t)res;
+    return res;
 }
 
 typedef struct {
@@ -1533,14 +3923,1124 @@ TapkiStr TapkiFileRead(TapkiArena *ar, const char *file)
     FILE* f = __tpk_open(file, "rb", "read");
     if (fseek(f, 0, SEEK_END))
         TapkiDie("Could not seek file: %s => [Errno: %d] %s\n", file, errno, strerror(errno));
-    TapkiStr str = __tapkis_withn(ar, ftell(f));
+    long size = ftell(f);
+    if (size < 0)
+        TapkiDie("Could not tell file size: %s => [Errno: %d] %s\n", file, errno, strerror(errno));
+    TapkiStr str = __tapkis_withn(ar, (size_t)size);
     rewind(f);
-    // TODO: why this errors with invalid seek and still reads ok?
-    fread(str.d, str.size, 1, f);
+    if (str.size && fread(str.d, str.size, 1, f) != 1)
+        TapkiDie("Could not read file: %s => %s\n", file, ferror(f) ? strerror(errno) : "unexpected end of file");
     fclose(f);
     return str;
 }
 
+#ifndef _WIN32
+static int __tpk_madvice(TapkiMapAdvice advice) {
+    switch (advice) {
+    case TAPKI_MAP_SEQUENTIAL: return MADV_SEQUENTIAL;
+    case TAPKI_MAP_RANDOM: return MADV_RANDOM;
+    case TAPKI_MAP_WILLNEED: return MADV_WILLNEED;
+    default: return MADV_NORMAL;
+    }
+}
+#endif
+
+TapkiStrView TapkiFileMap(TapkiArena *ar, const char *file, TapkiMapAdvice advice)
+{
+#ifdef _WIN32
+    (void)advice;
+    return TapkiSV(TapkiFileRead(ar, file));
+#else
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        TapkiDie("Could not open for map: %s => [Errno: %d] %s\n", file, errno, strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st))
+        TapkiDie("Could not stat file: %s => [Errno: %d] %s\n", file, errno, strerror(errno));
+    if (!S_ISREG(st.st_mode)) {
+        // pipes and devices cannot be mapped
+        close(fd);
+        return TapkiSV(TapkiFileRead(ar, file));
+    }
+    if (!st.st_size) {
+        close(fd);
+        return (TapkiStrView){"", 0};
+    }
+    size_t size = (size_t)st.st_size;
+    __TapkiLarge* block = (__TapkiLarge*)malloc(sizeof(__TapkiLarge) + sizeof(void*));
+    if (TAPKI_UNLIKELY(!block)) TapkiDie("arena.map.new");
+    void* mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (TAPKI_UNLIKELY(mem == MAP_FAILED))
+        TapkiDie("Could not map file: %s => [Errno: %d] %s\n", file, err, strerror(err));
+    if (advice != TAPKI_MAP_NORMAL) {
+        madvise(mem, size, __tpk_madvice(advice));
+    }
+    *(void**)block->buff = mem;
+    block->cap = 0;
+    block->mapped = size;
+    block->seq = ar->large_seq++;
+    block->next = ar->large;
+    ar->large = block;
+    return (TapkiStrView){(const char*)mem, size};
+#endif
+}
+
+void TapkiFileAdvise(TapkiStrView view, TapkiMapAdvice advice)
+{
+#ifdef _WIN32
+    (void)view; (void)advice;
+#else
+    if (!view.size) return;
+    // madvise wants page-aligned start
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)view.d & ~(uintptr_t)(page - 1);
+    madvise((void*)start, (uintptr_t)view.d + view.size - start, __tpk_madvice(advice));
+#endif
+}
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define __tpk_fd_open(path) _open(path, _O_RDONLY | _O_BINARY)
+#define __tpk_fd_read(fd, buf, n) _read(fd, buf, (unsigned)(n))
+#define __tpk_fd_close(fd) _close(fd)
+#else
+#define __tpk_fd_open(path) open(path, O_RDONLY | O_CLOEXEC)
+#define __tpk_fd_read(fd, buf, n) read(fd, buf, n)
+#define __tpk_fd_close(fd) close(fd)
+#endif
+
+struct TapkiReader {
+    TapkiArena* ar;
+    const char* name;
+    int fd;
+    bool owned;
+    bool eof;
+    size_t pos; // start of unconsumed data, buf.size is end of read data
+    TapkiStr buf;
+};
+
+static TapkiReader* __tpk_reader_new(TapkiArena* ar, int fd, const char* name, bool owned)
+{
+    TapkiReader* r = (TapkiReader*)TapkiArenaAlloc(ar, sizeof(TapkiReader));
+    r->ar = ar;
+    r->name = name;
+    r->fd = fd;
+    r->owned = owned;
+    TapkiVecReserve(ar, &r->buf, TAPKI_READER_BUFFER);
+    return r;
+}
+
+TapkiReader* TapkiReaderOpen(TapkiArena* ar, const char* path)
+{
+    if (strcmp(path, "-") == 0) {
+        return __tpk_reader_new(ar, 0, "<stdin>", false);
+    }
+    int fd = __tpk_fd_open(path);
+    if (fd < 0)
+        TapkiDie("Could not open for read: %s => [Errno: %d] %s\n", path, errno, strerror(errno));
+    return __tpk_reader_new(ar, fd, TapkiS(ar, path).d, true);
+}
+
+TapkiReader* TapkiReaderOpenFd(TapkiArena* ar, int fd)
+{
+    return __tpk_reader_new(ar, fd, TapkiF(ar, "<fd %d>", fd).d, false);
+}
+
+void TapkiReaderClose(TapkiReader* r)
+{
+    if (r->owned) {
+        __tpk_fd_close(r->fd);
+        r->owned = false;
+    }
+    r->eof = true;
+    r->pos = r->buf.size;
+}
+
+// Moves unconsumed tail to the front and appends more input. False on end of input
+static bool __tpk_reader_fill(TapkiReader* r)
+{
+    size_t tail = r->buf.size - r->pos;
+    if (r->pos) {
+        memmove(r->buf.d, r->buf.d + r->pos, tail);
+        r->buf.size = tail;
+        r->pos = 0;
+    }
+    if (r->buf.cap - r->buf.size <= TAPKI_READER_BUFFER / 2) {
+        // record longer than buffer: grow geometrically
+        TapkiVecReserve(r->ar, &r->buf, r->buf.cap * 2);
+    }
+    for (;;) {
+        // keep room for NUL, buf stays a valid Str
+        long n = (long)__tpk_fd_read(r->fd, r->buf.d + r->buf.size, r->buf.cap - r->buf.size - 1);
+        if (n > 0) {
+            r->buf.size += (size_t)n;
+            r->buf.d[r->buf.size] = 0;
+            return true;
+        }
+        if (n == 0) break;
+        if (errno != EINTR)
+            TapkiDie("Could not read: %s => [Errno: %d] %s\n", r->name, errno, strerror(errno));
+    }
+    if (r->owned) {
+        __tpk_fd_close(r->fd);
+        r->owned = false;
+    }
+    r->eof = true;
+    return false;
+}
+
+bool TapkiReaderNextRecord(TapkiReader* r, char delim, TapkiStrView* record)
+{
+    size_t scanned = 0;
+    for (;;) {
+        const char* start = r->buf.d + r->pos;
+        size_t avail = r->buf.size - r->pos;
+        const char* hit = (const char*)memchr(start + scanned, delim, avail - scanned);
+        if (hit) {
+            *record = (TapkiStrView){start, (size_t)(hit - start)};
+            r->pos += record->size + 1;
+            return true;
+        }
+        if (r->eof || !__tpk_reader_fill(r)) {
+            if (!avail) return false;
+            *record = (TapkiStrView){r->buf.d + r->pos, avail};
+            r->pos = r->buf.size;
+            return true;
+        }
+        scanned = avail;
+    }
+}
+
+bool TapkiReaderNextLine(TapkiReader* r, TapkiStrView* line)
+{
+    if (!TapkiReaderNextRecord(r, '\n', line)) return false;
+    if (line->size && line->d[line->size - 1] == '\r') line->size--;
+    return true;
+}
+
+typedef struct {
+    const char* path;
+    __TapkiLarge* block; // malloc-ed by reader thread, adopted by arena afterwards
+    size_t size;
+    size_t hint; // expected size, 0 if unknown
+    const char* failed; // step that failed
+    int err;
+} __tpk_read_job;
+
+static void __tpk_read_job_fail(__tpk_read_job* job, const char* step, int err) {
+    if (!job->failed) {
+        job->failed = step;
+        job->err = err;
+    }
+}
+
+// Ensures room for at least one more byte (+ NUL)
+static bool __tpk_read_job_room(__tpk_read_job* job) {
+    size_t cap = job->block ? job->block->cap : 0;
+    if (job->size + 1 < cap) return true;
+    cap = cap ? cap * 2 : job->hint ? job->hint + 1 : 4096;
+    __TapkiLarge* block = (__TapkiLarge*)realloc(job->block, sizeof(__TapkiLarge) + cap);
+    if (!block) {
+        __tpk_read_job_fail(job, "allocate", ENOMEM);
+        return false;
+    }
+    block->cap = cap;
+    job->block = block;
+    return true;
+}
+
+// Read is complete when expected size is reached or on end of file
+static bool __tpk_read_job_done(__tpk_read_job* job, size_t got) {
+    job->size += got;
+    return !got || (job->hint && job->size >= job->hint);
+}
+
+static TapkiStrVec __tpk_read_adopt(TapkiArena* ar, __tpk_read_job* jobs, size_t count)
+{
+    TapkiStrVec res = {0};
+    TapkiVecReserve(ar, &res, count);
+    const __tpk_read_job* failed = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        __tpk_read_job* job = &jobs[i];
+        if (job->failed && !failed) failed = job;
+        TapkiStr* str = &res.d[res.size++];
+        if (job->failed || !job->block) {
+            free(job->block);
+            *str = TapkiS(ar, "");
+            continue;
+        }
+        __TapkiLarge* block = job->block;
+        block->buff[job->size] = 0;
+        block->seq = ar->large_seq++;
+        block->mapped = 0;
+        block->next = ar->large;
+        ar->large = block;
+        *str = (TapkiStr){block->buff, job->size, block->cap};
+    }
+    if (failed)
+        TapkiDie("Could not %s file: %s => [Errno: %d] %s\n", failed->failed, failed->path, failed->err, strerror(failed->err));
+    return res;
+}
+
+#ifndef _WIN32
+#include <pthread.h>
+
+static void __tpk_read_one(__tpk_read_job* job)
+{
+    int fd = __tpk_fd_open(job->path);
+    if (fd < 0) {
+        __tpk_read_job_fail(job, "open", errno);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        __tpk_read_job_fail(job, "stat", errno);
+    } else {
+        job->hint = S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+        while (__tpk_read_job_room(job)) {
+            ssize_t n = pread(fd, job->block->buff + job->size, job->block->cap - job->size - 1, (off_t)job->size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                __tpk_read_job_fail(job, "read", errno);
+                break;
+            }
+            if (__tpk_read_job_done(job, (size_t)n)) break;
+        }
+    }
+    close(fd);
+}
+
+typedef struct {
+    __tpk_read_job* jobs;
+    size_t count;
+    size_t next; // atomic
+} __tpk_read_pool;
+
+static void* __tpk_read_worker(void* arg)
+{
+    __tpk_read_pool* pool = (__tpk_read_pool*)arg;
+    for (;;) {
+        size_t i = __tpk_atomic_add(&pool->next, 1);
+        if (i >= pool->count) break;
+        __tpk_read_one(&pool->jobs[i]);
+    }
+    return NULL;
+}
+
+static void __tpk_read_threads(__tpk_read_job* jobs, size_t count)
+{
+    __tpk_read_pool pool = {jobs, count, 0};
+    pthread_t threads[TAPKI_READ_MANY_THREADS];
+    size_t started = 0;
+    while (started + 1 < count && started < TAPKI_READ_MANY_THREADS) {
+        if (pthread_create(&threads[started], NULL, __tpk_read_worker, &pool)) break;
+        started++;
+    }
+    __tpk_read_worker(&pool);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+}
+#endif
+
+// io_uring path needs kernel headers of 5.6+ (OPENAT/STATX/CLOSE came with IORING_FEAT_RW_CUR_POS),
+// otherwise TapkiFileReadMany() quietly falls back to threads
+#if defined(__linux__) && !defined(TAPKI_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/syscall.h>
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(STATX_SIZE) && defined(__NR_io_uring_setup)
+#define __TPK_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef __TPK_IO_URING
+
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;
+    void* cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    unsigned to_submit;
+} __tpk_uring;
+
+enum { __TPK_URING_OPEN, __TPK_URING_STATX, __TPK_URING_READ, __TPK_URING_CLOSE };
+
+typedef struct {
+    __tpk_read_job job;
+    int fd;
+    int pending; // open + statx in flight
+    struct statx stx;
+} __tpk_uring_file;
+
+static void __tpk_uring_free(__tpk_uring* r)
+{
+    if (r->sqes && r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_len);
+    if (r->cq_ptr && r->cq_ptr != MAP_FAILED && r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_len);
+    if (r->sq_ptr && r->sq_ptr != MAP_FAILED) munmap(r->sq_ptr, r->sq_len);
+    close(r->fd);
+}
+
+static bool __tpk_uring_init(__tpk_uring* r, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) return false;
+    // OPENAT/STATX/CLOSE came in 5.6 together with this feature flag
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(r->fd);
+        return false;
+    }
+    r->entries = p.sq_entries;
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_len > r->sq_len) r->sq_len = r->cq_len;
+        r->cq_len = r->sq_len;
+    }
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQ_RING);
+    r->cq_ptr = p.features & IORING_FEAT_SINGLE_MMAP ? r->sq_ptr
+        : mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_CQ_RING);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQES);
+    if (r->sq_ptr == MAP_FAILED || r->cq_ptr == MAP_FAILED || r->sqes == MAP_FAILED) {
+        __tpk_uring_free(r);
+        return false;
+    }
+    char* sq = (char*)r->sq_ptr;
+    char* cq = (char*)r->cq_ptr;
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return true;
+}
+
+// Caller keeps in-flight ops below ring size, so there is always a free entry
+static struct io_uring_sqe* __tpk_uring_sqe(__tpk_uring* r, int fd, uint8_t op, size_t file, unsigned kind)
+{
+    unsigned tail = *r->sq_tail;
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->user_data = (uint64_t)file << 2 | kind;
+    r->sq_array[idx] = idx;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+    return sqe;
+}
+
+static void __tpk_uring_read(__tpk_uring* r, __tpk_uring_file* f, size_t i)
+{
+    struct io_uring_sqe* sqe = __tpk_uring_sqe(r, f->fd, IORING_OP_READ, i, __TPK_URING_READ);
+    sqe->addr = (uint64_t)(uintptr_t)(f->job.block->buff + f->job.size);
+    size_t room = f->job.block->cap - f->job.size - 1;
+    sqe->len = room < (1u << 30) ? (unsigned)room : (1u << 30);
+    sqe->off = f->job.size;
+}
+
+static bool __tpk_read_uring(__tpk_read_job* jobs, size_t count)
+{
+    __tpk_uring r;
+    // each file has at most 2 ops in flight
+    if (!__tpk_uring_init(&r, 2 * TAPKI_READ_MANY_DEPTH)) return false;
+    unsigned depth = r.entries / 2;
+    __tpk_uring_file* files = (__tpk_uring_file*)calloc(count, sizeof(__tpk_uring_file));
+    if (TAPKI_UNLIKELY(!files)) TapkiDie("read_many.new");
+    size_t next = 0, active = 0, inflight = 0;
+    while (next < count || inflight) {
+        for (; next < count && active < depth; ++next, ++active) {
+            __tpk_uring_file* f = &files[next];
+            f->job.path = jobs[next].path;
+            f->fd = -1;
+            f->pending = 2;
+            struct io_uring_sqe* sqe = __tpk_uring_sqe(&r, AT_FDCWD, IORING_OP_OPENAT, next, __TPK_URING_OPEN);
+            sqe->addr = (uint64_t)(uintptr_t)f->job.path;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe = __tpk_uring_sqe(&r, AT_FDCWD, IORING_OP_STATX, next, __TPK_URING_STATX);
+            sqe->addr = (uint64_t)(uintptr_t)f->job.path;
+            sqe->len = STATX_TYPE | STATX_SIZE;
+            sqe->off = (uint64_t)(uintptr_t)&f->stx;
+            inflight += 2;
+        }
+        int got = (int)syscall(__NR_io_uring_enter, r.fd, r.to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            TapkiDie("read_many.io_uring_enter: [Errno: %d] %s", errno, strerror(errno));
+        }
+        r.to_submit -= (unsigned)got;
+        unsigned head = *r.cq_head;
+        unsigned tail = __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            struct io_uring_cqe* cqe = &r.cqes[head & *r.cq_mask];
+            size_t i = (size_t)(cqe->user_data >> 2);
+            int res = cqe->res;
+            __tpk_uring_file* f = &files[i];
+            inflight--;
+            switch (cqe->user_data & 3) {
+            case __TPK_URING_OPEN:
+            case __TPK_URING_STATX:
+                if ((cqe->user_data & 3) == __TPK_URING_OPEN) {
+                    if (res < 0) __tpk_read_job_fail(&f->job, "open", -res);
+                    else f->fd = res;
+                } else {
+                    if (res < 0) __tpk_read_job_fail(&f->job, "stat", -res);
+                    else f->job.hint = S_ISREG(f->stx.stx_mode) ? (size_t)f->stx.stx_size : 0;
+                }
+                if (--f->pending) break;
+                if (!f->job.failed && __tpk_read_job_room(&f->job)) {
+                    __tpk_uring_read(&r, f, i);
+                    inflight++;
+                    break;
+                }
+                goto close;
+            case __TPK_URING_READ:
+                if (res == -EINTR || res == -EAGAIN) {
+                    __tpk_uring_read(&r, f, i);
+                    inflight++;
+                    break;
+                }
+                if (res < 0) {
+                    __tpk_read_job_fail(&f->job, "read", -res);
+                } else if (!__tpk_read_job_done(&f->job, (size_t)res) && __tpk_read_job_room(&f->job)) {
+                    __tpk_uring_read(&r, f, i);
+                    inflight++;
+                    break;
+                }
+            close:
+                if (f->fd < 0) {
+                    active--;
+                    break;
+                }
+                __tpk_uring_sqe(&r, f->fd, IORING_OP_CLOSE, i, __TPK_URING_CLOSE);
+                inflight++;
+                break;
+            case __TPK_URING_CLOSE:
+                active--;
+                break;
+            }
+        }
+        __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+    }
+    __tpk_uring_free(&r);
+    for (size_t i = 0; i < count; ++i) {
+        jobs[i] = files[i].job;
+    }
+    free(files);
+    return true;
+}
+#endif
+
+TapkiStrVec TapkiFileReadMany(TapkiArena* ar, const char* const* paths, size_t count)
+{
+#ifdef _WIN32
+    TapkiStrVec res = {0};
+    TapkiVecReserve(ar, &res, count);
+    for (size_t i = 0; i < count; ++i) {
+        res.d[res.size++] = TapkiFileRead(ar, paths[i]);
+    }
+    return res;
+#else
+    __tpk_read_job* jobs = (__tpk_read_job*)TapkiArenaAlloc(ar, sizeof(__tpk_read_job) * count);
+    for (size_t i = 0; i < count; ++i) {
+        jobs[i].path = paths[i];
+    }
+#ifdef __TPK_IO_URING
+    if (!__tpk_read_uring(jobs, count))
+#endif
+        __tpk_read_threads(jobs, count);
+    return __tpk_read_adopt(ar, jobs, count);
+#endif
+}
+
+#ifdef _WIN32
+#include <process.h>
+#include <sys/stat.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef struct { void* iov_base; size_t iov_len; } __tpk_iov;
+#define __tpk_fd_create(path, flags) _open(path, _O_WRONLY | _O_CREAT | _O_BINARY | (flags), _S_IREAD | _S_IWRITE)
+#define __TPK_O_TRUNC _O_TRUNC
+#define __TPK_O_APPEND _O_APPEND
+#define __TPK_O_EXCL _O_EXCL
+#define __tpk_fd_sync(fd) _commit(fd)
+#define __tpk_getpid() _getpid()
+#define __tpk_replace(from, to) (MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1)
+#else
+#include <sys/uio.h>
+typedef struct iovec __tpk_iov;
+#define __tpk_fd_create(path, flags) open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (flags), 0666)
+#define __TPK_O_TRUNC O_TRUNC
+#define __TPK_O_APPEND O_APPEND
+#define __TPK_O_EXCL O_EXCL
+#define __tpk_fd_sync(fd) fsync(fd)
+#define __tpk_getpid() getpid()
+#define __tpk_replace(from, to) rename(from, to)
+#endif
+
+#define __TPK_WRITER_IOV 64
+
+struct TapkiWriter {
+    const char* name;
+    const char* target; // atomic mode: file to replace on close
+    int fd;
+    bool owned;
+    size_t used;
+    char buff[TAPKI_WRITER_BUFFER];
+};
+
+static TapkiWriter* __tpk_writer_new(TapkiArena* ar, int fd, const char* name, bool owned)
+{
+    TapkiWriter* w = (TapkiWriter*)TapkiArenaAllocUninit(ar, sizeof(TapkiWriter), _Alignof(TapkiWriter));
+    w->name = name;
+    w->target = NULL;
+    w->fd = fd;
+    w->owned = owned;
+    w->used = 0;
+    return w;
+}
+
+TapkiWriter* TapkiWriterOpen(TapkiArena* ar, const char* path, TapkiWriteMode mode)
+{
+    if (strcmp(path, "-") == 0) {
+        return __tpk_writer_new(ar, 1, "<stdout>", false);
+    }
+    if (mode != TAPKI_WRITE_ATOMIC) {
+        int fd = __tpk_fd_create(path, mode == TAPKI_WRITE_APPEND ? __TPK_O_APPEND : __TPK_O_TRUNC);
+        if (fd < 0)
+            TapkiDie("Could not open for write: %s => [Errno: %d] %s\n", path, errno, strerror(errno));
+        return __tpk_writer_new(ar, fd, TapkiS(ar, path).d, true);
+    }
+    // Same directory as target, so rename never crosses filesystems
+    static size_t counter;
+    for (;;) {
+        TapkiStr tmp = TapkiF(ar, "%s.%d.%u.tmp", path, (int)__tpk_getpid(), (unsigned)__tpk_atomic_add(&counter, 1));
+        int fd = __tpk_fd_create(tmp.d, __TPK_O_EXCL);
+        if (fd < 0 && errno == EEXIST) continue;
+        if (fd < 0)
+            TapkiDie("Could not open for write: %s => [Errno: %d] %s\n", tmp.d, errno, strerror(errno));
+        TapkiWriter* w = __tpk_writer_new(ar, fd, tmp.d, true);
+        w->target = TapkiS(ar, path).d;
+        return w;
+    }
+}
+
+TapkiWriter* TapkiWriterOpenFd(TapkiArena* ar, int fd)
+{
+    return __tpk_writer_new(ar, fd, TapkiF(ar, "<fd %d>", fd).d, false);
+}
+
+// Writes all of iov, resuming after partial writes
+static void __tpk_writer_write(TapkiWriter* w, __tpk_iov* iov, int count)
+{
+    while (count) {
+#ifdef _WIN32
+        long n = _write(w->fd, iov->iov_base, iov->iov_len < (1u << 30) ? (unsigned)iov->iov_len : (1u << 30));
+#else
+        long n = (long)writev(w->fd, iov, count);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            TapkiDie("Could not write: %s => [Errno: %d] %s\n", w->name, errno, strerror(errno));
+        }
+        size_t done = (size_t)n;
+        while (count && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = (char*)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+}
+
+void TapkiWriterFlush(TapkiWriter* w)
+{
+    if (!w->used) return;
+    __tpk_iov iov = {w->buff, w->used};
+    w->used = 0;
+    __tpk_writer_write(w, &iov, 1);
+}
+
+void TapkiWriterAppend(TapkiWriter* w, const void* data, size_t len)
+{
+    if (len <= sizeof(w->buff) - w->used) {
+        _TAPKI_MEMCPY(w->buff + w->used, data, len);
+        w->used += len;
+        return;
+    }
+    if (len < sizeof(w->buff)) {
+        TapkiWriterFlush(w);
+        memcpy(w->buff, data, len);
+        w->used = len;
+        return;
+    }
+    __tpk_iov iov[2] = {{w->buff, w->used}, {(void*)data, len}};
+    w->used = 0;
+    __tpk_writer_write(w, iov, 2);
+}
+
+void TapkiWriterAppendStrs(TapkiWriter* w, const TapkiStr* strs, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += strs[i].size;
+    }
+    if (total <= sizeof(w->buff) - w->used) {
+        for (size_t i = 0; i < count; ++i) {
+            _TAPKI_MEMCPY(w->buff + w->used, strs[i].d, strs[i].size);
+            w->used += strs[i].size;
+        }
+        return;
+    }
+    __tpk_iov iov[__TPK_WRITER_IOV];
+    int n = 0;
+    iov[n].iov_base = w->buff;
+    iov[n++].iov_len = w->used;
+    w->used = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (n == __TPK_WRITER_IOV) {
+            __tpk_writer_write(w, iov, n);
+            n = 0;
+        }
+        iov[n].iov_base = strs[i].d;
+        iov[n++].iov_len = strs[i].size;
+    }
+    __tpk_writer_write(w, iov, n);
+}
+
+void TapkiWriterClose(TapkiWriter* w)
+{
+    if (w->fd < 0) return;
+    TapkiWriterFlush(w);
+    if (w->target && __tpk_fd_sync(w->fd))
+        TapkiDie("Could not sync: %s => [Errno: %d] %s\n", w->name, errno, strerror(errno));
+    if (w->owned && __tpk_fd_close(w->fd))
+        TapkiDie("Could not close: %s => [Errno: %d] %s\n", w->name, errno, strerror(errno));
+    w->fd = -1;
+    if (w->target && __tpk_replace(w->name, w->target))
+        TapkiDie("Could not rename %s to %s => [Errno: %d] %s\n", w->name, w->target, errno, strerror(errno));
+}
+
+// "func (file:line) fmt", with ';' and newlines of fmt replaced for line-based formats
+static void __tpk_frame_label(TapkiArena* ar, TapkiStr* out, const char* loc, const char* func, const char* fmt)
+{
+    const char* file = loc;
+    for (const char* it = file; *it; ++it) {
+        if (*it == '/' || *it == '\\') file = it + 1;
+    }
+    TapkiStrAppend(ar, out, func, " (", file, ")");
+    if (fmt && *fmt) {
+        *TapkiVecPush(ar, out) = ' ';
+        for (const char* it = fmt; *it; ++it) {
+            *TapkiVecPush(ar, out) = *it == ';' || *it == '\n' ? ',' : *it;
+        }
+    }
+}
+
+#include <time.h>
+
+static uint64_t __tpk_now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+typedef struct {
+    const char* loc; // key with fmt (frames on one line share loc), NULL if slot is free
+    const char* func;
+    const char* fmt;
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t self_ns;
+} __tpk_zone;
+
+typedef struct {
+    const char* loc;
+    const char* func;
+    const char* fmt;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+} __tpk_trace_event;
+
+typedef struct __tpk_timing {
+    struct __tpk_timing* next; // all threads that ever recorded timing
+    size_t tid;
+    __tpk_zone* zones; // open addressing by loc
+    size_t zones_cap;
+    size_t zones_count;
+    TapkiVec(__tpk_trace_event) events;
+    size_t dropped;
+} __tpk_timing;
+
+static bool __tpk_timing_trace;
+static uint64_t __tpk_timing_epoch;
+static __tpk_timing* __tpk_timings; // atomic
+static size_t __tpk_timing_tids; // atomic
+
+void TapkiFrameTimingStart(bool trace)
+{
+    if (!__tpk_timing_epoch) __tpk_timing_epoch = __tpk_now_ns();
+    __tpk_relaxed_store(&__tpk_timing_trace, trace);
+    __tpk_relaxed_store(&__tpk_timing_on, true);
+}
+
+void TapkiFrameTimingStop(void)
+{
+    __tpk_relaxed_store(&__tpk_timing_on, false);
+}
+
+void TapkiFrameTimingReset(void)
+{
+    for (__tpk_timing* t = __tpk_atomic_load(&__tpk_timings); t; t = t->next) {
+        memset(t->zones, 0, t->zones_cap * sizeof(__tpk_zone));
+        t->zones_count = 0;
+        t->events.size = 0;
+        t->dropped = 0;
+    }
+    __tpk_timing_epoch = __tpk_relaxed_load(&__tpk_timing_on) ? __tpk_now_ns() : 0;
+}
+
+static __tpk_zone* __tpk_zone_slot(__tpk_zone* zones, size_t cap, const char* loc, const char* fmt)
+{
+    size_t i = (((uintptr_t)loc ^ (uintptr_t)fmt) * 0x9E3779B97F4A7C15ull) >> 16;
+    for (;; ++i) {
+        __tpk_zone* zone = &zones[i & (cap - 1)];
+        if ((zone->loc == loc && zone->fmt == fmt) || !zone->loc) return zone;
+    }
+}
+
+static __tpk_zone* __tpk_zone_get(__tpk_frames* frames, __tpk_timing* t, const __tpk_scope* scope)
+{
+    __tpk_zone* zone = __tpk_zone_slot(t->zones, t->zones_cap, scope->loc, scope->fmt);
+    if (zone->loc) return zone;
+    if (2 * (t->zones_count + 1) > t->zones_cap) {
+        size_t cap = t->zones_cap * 2;
+        __tpk_zone* zones = (__tpk_zone*)TapkiArenaAllocAligned(frames->arena, cap * sizeof(__tpk_zone), _Alignof(__tpk_zone));
+        for (size_t i = 0; i < t->zones_cap; ++i) {
+            if (t->zones[i].loc) *__tpk_zone_slot(zones, cap, t->zones[i].loc, t->zones[i].fmt) = t->zones[i];
+        }
+        t->zones = zones;
+        t->zones_cap = cap;
+        zone = __tpk_zone_slot(zones, cap, scope->loc, scope->fmt);
+    }
+    t->zones_count++;
+    zone->loc = scope->loc;
+    zone->func = scope->func;
+    zone->fmt = scope->fmt;
+    return zone;
+}
+
+static __tpk_timing* __tpk_timing_new(__tpk_frames* frames)
+{
+    __tpk_timing* t = (__tpk_timing*)TapkiArenaAlloc(frames->arena, sizeof(__tpk_timing));
+    t->tid = __tpk_atomic_add(&__tpk_timing_tids, 1) + 1;
+    t->zones_cap = 64;
+    t->zones = (__tpk_zone*)TapkiArenaAllocAligned(frames->arena, t->zones_cap * sizeof(__tpk_zone), _Alignof(__tpk_zone));
+    __tpk_timing* head = __tpk_atomic_load(&__tpk_timings);
+    do {
+        t->next = head;
+    } while (!__tpk_atomic_cas(&__tpk_timings, &head, t));
+    frames->timing = t;
+    return t;
+}
+
+static void __tpk_timing_leave(__tpk_frames* frames, __tpk_scope* scope)
+{
+    uint64_t end = __tpk_now_ns();
+    uint64_t dur = end - scope->start_ns;
+    if (frames->frames.size) {
+        frames->frames.d[frames->frames.size - 1].s->child_ns += dur;
+    }
+    if (!__tpk_relaxed_load(&__tpk_timing_on)) return;
+    __tpk_timing* t = frames->timing ? frames->timing : __tpk_timing_new(frames);
+    __tpk_zone* zone = __tpk_zone_get(frames, t, scope);
+    zone->calls++;
+    zone->total_ns += dur;
+    zone->self_ns += dur > scope->child_ns ? dur - scope->child_ns : 0;
+    if (__tpk_relaxed_load(&__tpk_timing_trace)) {
+        if (t->events.size < TAPKI_TRACE_EVENTS) {
+            *TapkiVecPush(frames->arena, &t->events) = (__tpk_trace_event){scope->loc, scope->func, scope->fmt, scope->start_ns, dur};
+        } else {
+            t->dropped++;
+        }
+    }
+}
+
+static int __tpk_zone_by_loc(const void* a, const void* b)
+{
+    const __tpk_zone* l = (const __tpk_zone*)a;
+    const __tpk_zone* r = (const __tpk_zone*)b;
+    if (l->loc != r->loc) return (uintptr_t)l->loc < (uintptr_t)r->loc ? -1 : 1;
+    return (uintptr_t)l->fmt < (uintptr_t)r->fmt ? -1 : (uintptr_t)l->fmt > (uintptr_t)r->fmt;
+}
+
+static int __tpk_zone_by_self(const void* a, const void* b)
+{
+    uint64_t l = ((const __tpk_zone*)a)->self_ns, r = ((const __tpk_zone*)b)->self_ns;
+    return l > r ? -1 : l < r;
+}
+
+TapkiStr TapkiFrameReport(TapkiArena* ar)
+{
+    TapkiVec(__tpk_zone) all = {0};
+    for (__tpk_timing* t = __tpk_atomic_load(&__tpk_timings); t; t = t->next) {
+        for (size_t i = 0; i < t->zones_cap; ++i) {
+            if (t->zones[i].loc) *TapkiVecPush(ar, &all) = t->zones[i];
+        }
+    }
+    // same location from several threads
+    size_t merged = 0;
+    if (all.size) {
+        qsort(all.d, all.size, sizeof(__tpk_zone), __tpk_zone_by_loc);
+        for (size_t i = 1; i < all.size; ++i) {
+            __tpk_zone* last = &all.d[merged];
+            if (all.d[i].loc == last->loc && all.d[i].fmt == last->fmt) {
+                last->calls += all.d[i].calls;
+                last->total_ns += all.d[i].total_ns;
+                last->self_ns += all.d[i].self_ns;
+            } else {
+                all.d[++merged] = all.d[i];
+            }
+        }
+        qsort(all.d, ++merged, sizeof(__tpk_zone), __tpk_zone_by_self);
+    }
+    TapkiStr out = TapkiF(ar, "%10s %10s %10s %10s  %s\n", "self ms", "total ms", "calls", "avg us", "scope");
+    for (size_t i = 0; i < merged; ++i) {
+        const __tpk_zone* z = &all.d[i];
+        TapkiStrAppendF(ar, &out, "%10.3f %10.3f %10llu %10.3f  ", z->self_ns / 1e6, z->total_ns / 1e6,
+                        (unsigned long long)z->calls, z->total_ns / 1e3 / (double)z->calls);
+        __tpk_frame_label(ar, &out, z->loc, z->func, z->fmt);
+        *TapkiVecPush(ar, &out) = '\n';
+    }
+    return out;
+}
+
+static void __tpk_json_str(TapkiArena* ar, TapkiStr* out, const char* s)
+{
+    *TapkiVecPush(ar, out) = '"';
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            TapkiStrAppend(ar, out, c == '"' ? "\\\"" : "\\\\");
+        } else if (c < 0x20) {
+            TapkiStrAppendF(ar, out, "\\u%04x", c);
+        } else {
+            *TapkiVecPush(ar, out) = (char)c;
+        }
+    }
+    *TapkiVecPush(ar, out) = '"';
+}
+
+TapkiStr TapkiFrameTraceJSON(TapkiArena* ar)
+{
+    TapkiStr out = TapkiS(ar, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    for (__tpk_timing* t = __tpk_atomic_load(&__tpk_timings); t; t = t->next) {
+        for (size_t i = 0; i < t->events.size; ++i) {
+            const __tpk_trace_event* e = &t->events.d[i];
+            // Scope was open during TapkiFrameTimingReset(): its start is before the epoch
+            if (e->start_ns < __tpk_timing_epoch) continue;
+            TapkiStrAppend(ar, &out, first ? "\n{\"name\":" : ",\n{\"name\":");
+            first = false;
+            __tpk_json_str(ar, &out, e->fmt && *e->fmt ? e->fmt : e->func);
+            TapkiStrAppend(ar, &out, ",\"cat\":\"frame\",\"ph\":\"X\"");
+            TapkiStrAppendF(ar, &out, ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu,\"args\":{\"func\":",
+                            (double)(e->start_ns - __tpk_timing_epoch) / 1e3, (double)e->dur_ns / 1e3, t->tid);
+            __tpk_json_str(ar, &out, e->func);
+            TapkiStrAppend(ar, &out, ",\"loc\":");
+            __tpk_json_str(ar, &out, e->loc);
+            TapkiStrAppend(ar, &out, "}}");
+        }
+        if (t->dropped) {
+            TapkiStrAppend(ar, &out, first ? "\n" : ",\n");
+            first = false;
+            TapkiStrAppendF(ar, &out, "{\"name\":\"dropped %zu events\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":1,\"tid\":%zu}",
+                            t->dropped, t->tid);
+        }
+    }
+    TapkiStrAppend(ar, &out, "\n]}\n");
+    return out;
+}
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/time.h>
+
+#if TAPKI_PROFILER_STACKS <= 0 || (TAPKI_PROFILER_STACKS & (TAPKI_PROFILER_STACKS - 1)) != 0
+#error "TAPKI_PROFILER_STACKS must be a power of two"
+#endif
+
+typedef struct {
+    const char* loc;
+    const char* func;
+    const char* fmt;
+} __tpk_prof_frame;
+
+typedef struct {
+    uint64_t hash; // atomic, 0 if slot is free
+    size_t count; // atomic
+    uint32_t start; // in __tpk_prof.frames, UINT32_MAX if there was no room
+    uint32_t depth;
+    int ready; // atomic, set once frames are copied
+} __tpk_prof_stack;
+
+static struct {
+    __tpk_prof_stack* stacks;
+    __tpk_prof_frame* frames;
+    size_t frames_used; // atomic
+    size_t dropped; // atomic
+    bool running;
+    struct sigaction old;
+} __tpk_prof;
+
+// Runs on the sampled thread: only lock-free atomics and its own frames are touched
+static void __tpk_prof_handler(int sig)
+{
+    (void)sig;
+    int saved_errno = errno;
+    const __tpk_frames* frames = &__tpk_gframes;
+    size_t depth = frames->frames.size;
+    __tpk_signal_fence();
+    if (depth > TAPKI_PROFILER_DEPTH) depth = TAPKI_PROFILER_DEPTH;
+    const __tpk_frame* d = frames->frames.d;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < depth; ++i) {
+        hash = (hash ^ (uintptr_t)d[i].s->loc) * 1099511628211ull;
+        hash = (hash ^ (uintptr_t)d[i].s->fmt) * 1099511628211ull;
+    }
+    hash = (hash ^ depth) | 1;
+    for (size_t probe = 0; probe < TAPKI_PROFILER_STACKS; ++probe) {
+        __tpk_prof_stack* slot = &__tpk_prof.stacks[(hash + probe) & (TAPKI_PROFILER_STACKS - 1)];
+        uint64_t cur = __tpk_atomic_load(&slot->hash);
+        if (!cur && __tpk_atomic_cas(&slot->hash, &cur, hash)) {
+            size_t start = __tpk_atomic_add(&__tpk_prof.frames_used, depth);
+            if (start + depth <= TAPKI_PROFILER_FRAMES) {
+                for (size_t i = 0; i < depth; ++i) {
+                    const __tpk_scope* s = d[i].s;
+                    __tpk_prof.frames[start + i] = (__tpk_prof_frame){s->loc, s->func, s->fmt};
+                }
+                slot->start = (uint32_t)start;
+            } else {
+                slot->start = UINT32_MAX;
+            }
+            slot->depth = (uint32_t)depth;
+            __atomic_store_n(&slot->ready, 1, __ATOMIC_RELEASE);
+            cur = hash;
+        }
+        if (cur == hash) {
+            __tpk_atomic_add(&slot->count, 1);
+            errno = saved_errno;
+            return;
+        }
+    }
+    __tpk_atomic_add(&__tpk_prof.dropped, 1);
+    errno = saved_errno;
+}
+
+void TapkiProfilerStart(int hz)
+{
+    if (__tpk_prof.running) return;
+    if (TAPKI_UNLIKELY(hz <= 0)) TapkiDie("profiler.start: invalid frequency: %d", hz);
+    if (!__tpk_prof.stacks) {
+        __tpk_prof.stacks = (__tpk_prof_stack*)calloc(TAPKI_PROFILER_STACKS, sizeof(__tpk_prof_stack));
+        __tpk_prof.frames = (__tpk_prof_frame*)calloc(TAPKI_PROFILER_FRAMES, sizeof(__tpk_prof_frame));
+        if (TAPKI_UNLIKELY(!__tpk_prof.stacks || !__tpk_prof.frames)) TapkiDie("profiler.new");
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = __tpk_prof_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, &__tpk_prof.old))
+        TapkiDie("profiler.sigaction: [Errno: %d] %s", errno, strerror(errno));
+    long usec = hz < 1000000 ? 1000000 / hz : 1;
+    struct itimerval timer = {{usec / 1000000, usec % 1000000}, {usec / 1000000, usec % 1000000}};
+    if (setitimer(ITIMER_PROF, &timer, NULL))
+        TapkiDie("profiler.setitimer: [Errno: %d] %s", errno, strerror(errno));
+    __tpk_prof.running = true;
+}
+
+void TapkiProfilerStop(void)
+{
+    if (!__tpk_prof.running) return;
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+    // Signal may still be pending after timer is disarmed: default action would kill the process
+    struct sigaction restore = __tpk_prof.old;
+    if (!(restore.sa_flags & SA_SIGINFO) && restore.sa_handler == SIG_DFL) restore.sa_handler = SIG_IGN;
+    sigaction(SIGPROF, &restore, NULL);
+    __tpk_prof.running = false;
+}
+
+void TapkiProfilerReset(void)
+{
+    if (TAPKI_UNLIKELY(__tpk_prof.running)) TapkiDie("profiler.reset: profiler is running");
+    if (!__tpk_prof.stacks) return;
+    memset(__tpk_prof.stacks, 0, TAPKI_PROFILER_STACKS * sizeof(__tpk_prof_stack));
+    __tpk_prof.frames_used = 0;
+    __tpk_prof.dropped = 0;
+}
+
+
+TapkiStr TapkiProfilerFolded(TapkiArena* ar)
+{
+    TapkiStr out = TapkiS(ar, "");
+    if (!__tpk_prof.stacks) return out;
+    for (size_t i = 0; i < TAPKI_PROFILER_STACKS; ++i) {
+        const __tpk_prof_stack* slot = &__tpk_prof.stacks[i];
+        if (!__atomic_load_n(&slot->ready, __ATOMIC_ACQUIRE)) continue;
+        if (!slot->depth) {
+            TapkiStrAppend(ar, &out, "[no frames]");
+        } else if (slot->start == UINT32_MAX) {
+            TapkiStrAppend(ar, &out, "[profiler full]");
+        }
+        for (uint32_t f = 0; slot->start != UINT32_MAX && f < slot->depth; ++f) {
+            if (f) *TapkiVecPush(ar, &out) = ';';
+            const __tpk_prof_frame* frame = &__tpk_prof.frames[slot->start + f];
+            __tpk_frame_label(ar, &out, frame->loc, frame->func, frame->fmt);
+        }
+        TapkiStrAppendF(ar, &out, " %zu\n", __tpk_atomic_load(&slot->count));
+    }
+    size_t dropped = __tpk_atomic_load(&__tpk_prof.dropped);
+    if (dropped) TapkiStrAppendF(ar, &out, "[dropped] %zu\n", dropped);
+    return out;
+}
+#else
+void TapkiProfilerStart(int hz) { (void)hz; }
+void TapkiProfilerStop(void) {}
+void TapkiProfilerReset(void) {}
+TapkiStr TapkiProfilerFolded(TapkiArena* ar) { return TapkiS(ar, ""); }
+#endif
+
 TapkiStr __tpk_path_join(TapkiArena *ar, const char **parts, size_t count)
 {
     TapkiStr res = {0};
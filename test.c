@@ -1,5 +1,11 @@
 ﻿#define TAPKI_IMPLEMENTATION
 #include "tapki.h"
+#include <locale.h>
+#include <time.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 #define ASSERT(...) Frame() { if (!(__VA_ARGS__)) Die("Test failed: " #__VA_ARGS__); } (void)0
 
@@ -20,12 +26,819 @@ void Test_Maps(Arena* arena) {
     ASSERT(strcmp(StrMap_Find(&map, "Kek")->d, "LolKek") == 0);
 }
 
+void Test_MapsBulk(Arena* arena) {
+    StrMap map = {0};
+    TapkiStrMap_Pair pairs[] = {
+        {"b", S("1")}, {"a", S("2")}, {"c", S("3")}, {"b", S("4")}, {"a", S("5")},
+    };
+    StrMap_BuildFrom(&map, pairs, 3);
+    StrMap_BuildFrom(&map, pairs + 3, 2);
+    StrMap_Finalize(&map);
+    ASSERT(map.size == 3);
+    ASSERT(strcmp(map.d[0].key, "a") == 0 && strcmp(map.d[0].value.d, "5") == 0);
+    ASSERT(strcmp(map.d[1].key, "b") == 0 && strcmp(map.d[1].value.d, "4") == 0);
+    ASSERT(strcmp(StrMap_Find(&map, "c")->d, "3") == 0);
+    *StrMap_At(&map, "0") = S("0");
+    ASSERT(map.size == 4 && strcmp(map.d[0].key, "0") == 0);
+}
+
+void Test_MapsFrozen(Arena* arena) {
+    StrKeyMap map = {0};
+    for (int i = 0; i < 300; i += 3) {
+        *StrKeyMap_At(&map, StrKey(F("%04d", i).d)) = F("%d", i);
+    }
+    StrKeyMap_Freeze(&map);
+    ASSERT(map.frozen);
+    for (int i = 0; i < 300; ++i) {
+        Str key = F("%04d", i);
+        Str* value = StrKeyMap_Find(&map, StrKey(key.d));
+        bool present = i % 3 == 0;
+        ASSERT(present ? value && ToI32(value->d) == i : !value);
+    }
+    ASSERT(!StrKeyMap_Find(&map, StrKey("9999")) && !StrKeyMap_Find(&map, StrKey("")));
+    *StrKeyMap_At(&map, StrKey("0001")) = S("1");
+    ASSERT(!map.frozen);
+    ASSERT(strcmp(StrKeyMap_Find(&map, StrKey("0001"))->d, "1") == 0);
+    // String maps keep binary search
+    StrMap smap = {0};
+    *StrMap_At(&smap, "a") = S("1");
+    StrMap_Freeze(&smap);
+    ASSERT(!smap.frozen && strcmp(StrMap_Find(&smap, "a")->d, "1") == 0);
+}
+
+void Test_StrKeyMaps(Arena* arena) {
+    const char* keys[] = {"", "a", "abcdefg", "abcdefgh", "abcdefghi", "abcdefghij", "abcdefgi", "b"};
+    size_t count = sizeof(keys) / sizeof(keys[0]);
+    StrKeyMap map = {0};
+    for (size_t i = count; i-- > 0;) {
+        *StrKeyMap_At(&map, StrKey(keys[i])) = S(keys[i]);
+    }
+    ASSERT(map.size == count);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT(strcmp(map.d[i].key.s, keys[i]) == 0);
+    }
+    StrKeyMap_Freeze(&map);
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT(strcmp(StrKeyMap_Find(&map, StrKey(keys[i]))->d, keys[i]) == 0);
+    }
+    ASSERT(!StrKeyMap_Find(&map, StrKey("abcdefghh")));
+    ASSERT(StrKeyMap_Erase(&map, StrKey("abcdefghi")));
+    ASSERT(!StrKeyMap_Find(&map, StrKey("abcdefghi")));
+}
+
+void Test_HashMaps(Arena* arena) {
+    StrHashMap map = {0};
+    for (int i = 0; i < 1000; ++i) {
+        *StrHashMap_At(&map, F("key%d", i).d) = F("%d", i);
+    }
+    ASSERT(map.size == 1000);
+    *StrHashMap_At(&map, "key5") = S("five");
+    ASSERT(map.size == 1000);
+    ASSERT(strcmp(StrHashMap_Find(&map, "key5")->d, "five") == 0);
+    ASSERT(strcmp(StrHashMap_Find(&map, "key999")->d, "999") == 0);
+    ASSERT(!StrHashMap_Find(&map, "key1000"));
+    for (int i = 0; i < 1000; i += 2) {
+        Str key = F("key%d", i);
+        ASSERT(StrHashMap_Erase(&map, key.d));
+    }
+    ASSERT(!StrHashMap_Erase(&map, "key0"));
+    ASSERT(map.size == 500);
+    for (int i = 1; i < 1000; i += 2) {
+        Str key = F("key%d", i);
+        Str* value = StrHashMap_Find(&map, key.d);
+        ASSERT(value && (i == 5 || ToI32(value->d) == i));
+    }
+    size_t count = 0;
+    HashMapForEach(&map, it) {
+        ASSERT(it->key[3] != 0);
+        count++;
+    }
+    ASSERT(count == map.size);
+    ASSERT(StrHashMap_At(&map, "new")->size == 0);
+}
+
+void Test_ArenaStats() {
+    Arena* arena = ArenaCreate(1024);
+    ArenaAllocAligned(arena, 1, 1);
+    ArenaAllocAligned(arena, 8, 8);
+    ArenaStats stats = ArenaStats(arena);
+    ASSERT(stats.allocated == 9 && stats.in_use == 16 && stats.chunks == 1);
+    IntVec a = {0}, b = {0};
+    for (int i = 0; i < 100; ++i) {
+        *VecPush(&a) = i;
+        *VecPush(&b) = i;
+    }
+    ArenaAlloc(arena, 4096);
+    stats = ArenaStats(arena);
+    ASSERT(stats.wasted_vec > 0 && stats.chunks > 1 && stats.largest_chunk >= 4096);
+    ArenaClear(arena);
+    stats = ArenaStats(arena);
+    ASSERT(stats.in_use == 0 && stats.high_water >= 4096 + 16);
+    ArenaFree(arena);
+}
+
+void Test_ArenaGrowth() {
+    Arena* arena = ArenaCreateEx(1024, 64 * 1024);
+    for (int i = 0; i < 1000; ++i) {
+        ArenaAlloc(arena, 1000);
+    }
+    ArenaStats stats = ArenaStats(arena);
+    ASSERT(stats.largest_chunk == 64 * 1024 && stats.chunks < 30);
+    ArenaFree(arena);
+    ArenaTrim();
+    arena = ArenaCreateEx(1024, 1024);
+    for (int i = 0; i < 10; ++i) {
+        ArenaAlloc(arena, 1000);
+    }
+    ASSERT(ArenaStats(arena).chunks == 10);
+    ArenaFree(arena);
+}
+
+void Test_ArenaRecycle() {
+    Arena* arena = ArenaCreate(4096);
+    char* first = ArenaAlloc(arena, 64);
+    ArenaFree(arena);
+#ifdef ASAN_DEFINE_REGION_MACROS
+    ASSERT(__asan_address_is_poisoned(first));
+#endif
+    arena = ArenaCreate(4096);
+    ASSERT(ArenaAlloc(arena, 64) == first);
+    ArenaFree(arena);
+    ArenaTrim();
+}
+
+#ifndef _WIN32
+static void* ArenaCacheWorker(void* data) {
+    (void)data;
+    Arena* arena = ArenaCreate(64 * 1024);
+    memset(ArenaAlloc(arena, 1000), 1, 1000);
+    ArenaFree(arena);
+    return NULL;
+}
+
+// Thread exit must release cached chunks (leak sanitizer would complain otherwise)
+void Test_ArenaCacheThreadExit() {
+    pthread_t thread;
+    ASSERT(pthread_create(&thread, NULL, ArenaCacheWorker, NULL) == 0);
+    pthread_join(thread, NULL);
+}
+#endif
+
+void Test_SharedArena() {
+    Arena* shared = ArenaCreateShared(64);
+    Arena* workers[] = {ArenaAttach(shared), ArenaAttach(shared)};
+    IntVec vecs[2] = {0};
+    for (int64_t i = 0; i < 1000; ++i) {
+        Arena* arena = workers[i & 1];
+        *VecPush(&vecs[i & 1]) = i;
+        memset(ArenaAlloc(arena, 100), 1, 100);
+    }
+    for (int64_t i = 0; i < 500; ++i) {
+        ASSERT(vecs[0].d[i] == i * 2 && vecs[1].d[i] == i * 2 + 1);
+    }
+    for (int i = 0; i < 2; ++i) {
+        ASSERT(((uintptr_t)ArenaAlloc(workers[i], 1) & 15) == 0);
+    }
+    Arena* arena = shared;
+    ASSERT(strcmp(S("own").d, "own") == 0);
+    ArenaFree(shared);
+}
+
+#ifndef _WIN32
+typedef struct {
+    Arena* shared;
+    IntVec vec;
+    char* blocks[2000];
+    bool aligned;
+} SharedWorker;
+
+static void* SharedArenaWorker(void* data) {
+    SharedWorker* w = (SharedWorker*)data;
+    Arena* arena = ArenaAttach(w->shared);
+    w->aligned = true;
+    for (int64_t i = 0; i < 2000; ++i) {
+        *VecPush(&w->vec) = i;
+        char* block = (char*)ArenaAlloc(arena, 1 + i % 200);
+        w->aligned &= ((uintptr_t)block & 15) == 0;
+        memset(block, (int)(uintptr_t)w, 1 + i % 200);
+        w->blocks[i] = block;
+    }
+    return NULL;
+}
+
+void Test_SharedArenaThreads() {
+    enum { THREADS = 4 };
+    static SharedWorker workers[THREADS];
+    pthread_t threads[THREADS];
+    Arena* shared = ArenaCreateShared(256);
+    for (int i = 0; i < THREADS; ++i) {
+        workers[i] = (SharedWorker){.shared = shared};
+        ASSERT(pthread_create(&threads[i], NULL, SharedArenaWorker, &workers[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < THREADS; ++i) {
+        SharedWorker* w = &workers[i];
+        ASSERT(w->aligned && w->vec.size == 2000);
+        for (int64_t j = 0; j < 2000; ++j) {
+            ASSERT(w->vec.d[j] == j);
+            for (int64_t k = 0; k < 1 + j % 200; ++k) {
+                ASSERT(w->blocks[j][k] == (char)(uintptr_t)w);
+            }
+        }
+    }
+    ArenaFree(shared);
+}
+#endif
+
+void Test_ArenaLargeVec() {
+    Arena* arena = ArenaCreate(1024);
+    IntVec a = {0}, b = {0};
+    ArenaPos pos = ArenaMark(arena);
+    for (int64_t i = 0; i < 100000; ++i) {
+        *VecPush(&a) = i;
+        *VecPush(&b) = -i;
+    }
+    for (int64_t i = 0; i < 100000; ++i) {
+        ASSERT(a.d[i] == i && b.d[i] == -i);
+    }
+    ArenaStats stats = ArenaStats(arena);
+    ASSERT(stats.large >= 2 * 100000 * sizeof(int64_t));
+    // Interleaved growth does not abandon buffers: only the small prefix moved out of chunks
+    ASSERT(stats.wasted_vec < 2 * TAPKI_ARENA_LARGE_VEC);
+    ASSERT(stats.large < 4 * 100000 * sizeof(int64_t));
+    ASSERT(VecShrink(&a) && a.cap == a.size && a.d[99999] == 99999);
+    // Appending string to itself across (realloc) growth
+    Str s = S("");
+    while (s.size < 2 * TAPKI_ARENA_LARGE_VEC) {
+        StrAppend(&s, s.size ? s.d : "ab");
+    }
+    size_t was = s.size;
+    StrAppendSV(&s, SV(s));
+    ASSERT(s.size == 2 * was && memcmp(s.d, s.d + was, was) == 0);
+    StrAppendF(&s, "%s", s.d);
+    ASSERT(s.size == 4 * was && memcmp(s.d, s.d + 2 * was, 2 * was) == 0);
+    StrAppendF(&s, "%d%s%s", 1, s.d, s.d);
+    ASSERT(s.size == 12 * was + 1 && memcmp(s.d + 4 * was + 1, s.d + 8 * was + 1, 4 * was) == 0);
+    StrAppendF(&s, "%5d%s", 1, s.d + s.size - 3);
+    ASSERT(s.size == 12 * was + 9 && s.d[s.size - 4] == '1');
+    ArenaRestore(arena, pos);
+    ASSERT(ArenaStats(arena).large == 0);
+    ArenaFree(arena);
+}
+
+void Test_SmallStrings(Arena* arena) {
+    ASSERT(sizeof(SStr) == 24);
+    SStr empty = {0};
+    ASSERT(SStrSize(&empty) == 0 && strcmp(SStrData(&empty), "") == 0);
+    size_t was = ArenaStats(arena).in_use;
+    SStr s = SS("alias");
+    SStrAppend(&s, "-", "x");
+    SStrAppendF(&s, "%d", 42);
+    ASSERT(TapkiSStrIsInline(&s) && SStrSize(&s) == 9 && strcmp(SStrData(&s), "alias-x42") == 0);
+    ASSERT(SStrFind(&s, "x4", 0) == 6);
+    ASSERT(ArenaStats(arena).in_use == was);
+    SStrAppend(&s, "0123456789abc");
+    ASSERT(TapkiSStrIsInline(&s) && SStrSize(&s) == TAPKI_SSTR_INLINE);
+    SStrAppend(&s, "!");
+    ASSERT(!TapkiSStrIsInline(&s) && strcmp(SStrData(&s), "alias-x420123456789abc!") == 0);
+    SStrAppendF(&s, "%s", "-tail");
+    ASSERT(strcmp(SStrData(&s), "alias-x420123456789abc!-tail") == 0);
+    SStr f = {0};
+    SStrAppendF(&f, "%s-%s", "a long formatted string", "that spills");
+    ASSERT(strcmp(SStrData(&f), "a long formatted string-that spills") == 0);
+    SStr self = SS("abcdefghijkl");
+    SStrAppend(&self, SStrData(&self));
+    ASSERT(SStrSize(&self) == 24 && strcmp(SStrData(&self), "abcdefghijklabcdefghijkl") == 0);
+    SStrAppend(&self, SStrData(&self) + 20);
+    ASSERT(strcmp(SStrData(&self), "abcdefghijklabcdefghijklijkl") == 0);
+    SStr selfF = SS("abc");
+    SStrAppendF(&selfF, "x%s", SStrData(&selfF));
+    ASSERT(strcmp(SStrData(&selfF), "abcxabc") == 0);
+    SStrAppendF(&selfF, "-%s-%s", SStrData(&selfF), SStrData(&selfF));
+    ASSERT(strcmp(SStrData(&selfF), "abcxabc-abcxabc-abcxabc") == 0);
+    SStrMap map = {0};
+    *SStrMap_At(&map, "k1") = SS("v1");
+    *SStrMap_At(&map, "k2") = SStrCopy("a value longer than inline", 26);
+    ASSERT(strcmp(SStrData(SStrMap_Find(&map, "k1")), "v1") == 0);
+    ASSERT(SStrSize(SStrMap_Find(&map, "k2")) == 26);
+    ASSERT(SStrMap_Erase(&map, "k1") && !SStrMap_Find(&map, "k1"));
+}
+
+void Test_StrViews(Arena* arena) {
+    Str src = S("a,bb,,ccc");
+    StrView v = SV(src);
+    ASSERT(SV_Find(v, SVOf(","), 0) == 1 && SV_Find(v, SVOf(","), 2) == 4);
+    ASSERT(SV_Find(v, SVOf("x"), 0) == npos && SV_Find(v, SVOf(""), 3) == 3);
+    ASSERT(SV_RevFind(v, SVOf(",")) == 5 && SV_RevFind(v, SVOf("a,")) == 0);
+    ASSERT(SV_StartsWith(v, SVOf("a,b")) && !SV_StartsWith(v, SVOf("b")));
+    ASSERT(SV_EndsWith(v, SVOf("cc")) && !SV_EndsWith(v, SVOf("b")));
+    ASSERT(SV_Contains(v, SVOf(",,")) && SV_Eq(SV_Sub(v, 2, 4), SVOf("bb")));
+    // Views need no terminator
+    StrView part = SV_Sub(v, 0, 4);
+    ASSERT(!SV_Contains(part, SVOf("ccc")) && SV_EndsWith(part, SVOf("bb")));
+    StrVec parts = SV_Split(v, SVOf(","));
+    ASSERT(parts.size == 4 && parts.d[1].size == 2 && strcmp(parts.d[1].d, "bb") == 0);
+    ASSERT(parts.d[2].size == 0 && strcmp(parts.d[3].d, "ccc") == 0);
+    ASSERT(SV_Split(v, SVOf("")).size == 1);
+    Str copy = SV_Copy(part);
+    StrAppendSV(&copy, SV_Sub(v, 5, npos));
+    ASSERT(strcmp(copy.d, "a,bb,ccc") == 0 && copy.size == 8);
+    ASSERT(StrEndsWith("abc", "bc") && !StrEndsWith("abc", "ab") && !StrEndsWith("bc", "abc"));
+    Str sub = StrSub("hello world", 6, 100);
+    ASSERT(sub.size == 5 && strcmp(sub.d, "world") == 0);
+    ASSERT(StrSplit("x--y", "--").size == 2);
+    StrViewVec views = SV_SplitViews(v, SVOf(","));
+    ASSERT(views.size == 4 && views.d[1].d == src.d + 2 && SV_Eq(views.d[3], SVOf("ccc")));
+    ASSERT(StrSplitViews("", ",").size == 1 && StrSplitViews("a,", ",").size == 2);
+    StrView rest = SVOf("k=v;;x"), tok;
+    const char* expect[] = {"k=v", "", "x"};
+    size_t n = 0;
+    while (StrSplitNext(&rest, SVOf(";"), &tok)) {
+        ASSERT(n < 3 && SV_Eq(tok, SVOf(expect[n])));
+        n++;
+    }
+    ASSERT(n == 3 && !StrSplitNext(&rest, SVOf(";"), &tok));
+    // Null view is an empty string for all splitters
+    Str none = {0};
+    rest = SV(none);
+    n = 0;
+    while (StrSplitNext(&rest, SVOf(";"), &tok)) {
+        ASSERT(tok.size == 0);
+        n++;
+    }
+    ASSERT(n == 1 && SV_Split(SV(none), SVOf(";")).size == 1 && SV_SplitViews(SV(none), SVOf(";")).size == 1);
+}
+
+static size_t NaiveFind(const char* h, const char* n, bool rev) {
+    size_t hn = strlen(h), nn = strlen(n), found = npos;
+    for (size_t i = 0; i + nn <= hn; ++i) {
+        if (memcmp(h + i, n, nn) == 0) {
+            found = i;
+            if (!rev) break;
+        }
+    }
+    return found;
+}
+
+void Test_StrSearch(Arena* arena) {
+    uint32_t seed = 7;
+    for (int iter = 0; iter < 2000; ++iter) {
+        size_t hn = (size_t)iter / 8, nn = 1 + (size_t)iter % 5;
+        Str h = {0}, n = {0};
+        for (size_t i = 0; i < hn + nn; ++i) {
+            seed = seed * 1103515245 + 12345;
+            *VecPush(i < hn ? &h : &n) = "ab"[(seed >> 16) & 1];
+        }
+        size_t fwd = NaiveFind(h.d ? h.d : "", n.d, false);
+        size_t rev = NaiveFind(h.d ? h.d : "", n.d, true);
+        ASSERT(StrFind(h.d, n.d, 0) == fwd && StrRevFind(h.d, n.d) == rev);
+        ASSERT(SV_Find(SV(h), SV(n), 0) == fwd && SV_RevFind(SV(h), SV(n)) == rev);
+        ASSERT(StrContains(h.d, n.d) == (fwd != npos));
+    }
+    Str path = S("/usr/local/lib/very/long/path/to/some/binary");
+    ASSERT(StrRevFind(path.d, "/") == 37 && StrFind(path.d, "/", 1) == 4);
+    ASSERT(StrFind("abc", "", 2) == 2 && StrFind("abc", "c", 5) == npos);
+    ASSERT(StrFind("abc", "", 3) == 3 && StrFind("abc", "", 4) == npos);
+    ASSERT(StrRevFind("abc", "") == 0 && SV_RevFind(SVOf("abc"), SVOf("")) == 3);
+    ASSERT(StrStartsWith("abc", "ab") && !StrStartsWith("abc", "bc"));
+}
+
+void Test_Matcher(Arena* arena) {
+    const char* needles[] = {"he", "she", "his", "hers", "", "she"};
+    Matcher* m = MatcherCreate(needles, 6);
+    StrView text = SVOf("ushers and his");
+    size_t needle = npos;
+    ASSERT(MatcherFind(m, text, 0, &needle) == 1 && needle == 1);
+    ASSERT(MatcherFind(m, text, 2, &needle) == 2 && needle == 0);
+    ASSERT(MatcherFind(m, text, 4, &needle) == 11 && needle == 2);
+    ASSERT(MatcherFind(m, text, 12, NULL) == npos);
+    MatchVec all = MatcherFindAll(m, text);
+    ASSERT(all.size == 4);
+    ASSERT(all.d[0].pos == 1 && all.d[0].needle == 1 && all.d[1].pos == 2 && all.d[1].needle == 0);
+    ASSERT(all.d[2].pos == 2 && all.d[2].needle == 3 && all.d[3].pos == 11 && all.d[3].needle == 2);
+    // Against single-needle search on random text
+    const char* words[] = {"ab", "bab", "aaa", "abba", "b"};
+    Matcher* wm = MatcherCreate(words, 5);
+    uint32_t seed = 3;
+    Str rnd = {0};
+    for (int i = 0; i < 500; ++i) {
+        seed = seed * 1103515245 + 12345;
+        *VecPush(&rnd) = "ab"[(seed >> 16) & 1];
+    }
+    MatchVec found = MatcherFindAll(wm, SV(rnd));
+    for (size_t w = 0; w < 5; ++w) {
+        size_t count = 0, first = npos;
+        VecForEach(&found, it) {
+            if (it->needle != w) continue;
+            if (first == npos) first = it->pos;
+            count++;
+        }
+        size_t expect = 0;
+        for (size_t pos = StrFind(rnd.d, words[w], 0); pos != npos; pos = StrFind(rnd.d, words[w], pos + 1)) {
+            expect++;
+        }
+        ASSERT(count == expect && first == StrFind(rnd.d, words[w], 0));
+    }
+}
+
+void Test_Format(Arena* arena) {
+    Str s = {0};
+    StrAppendF(&s, "%s|%d|%u|%ld|%lld|%zu|%c|%%|%i", "str", -42, 42u, -7L, -9000000000LL, (size_t)123, 'x', 0);
+    const char* simple = "str|-42|42|-7|-9000000000|123|x|%|0";
+    ASSERT(strcmp(s.d, simple) == 0 && s.size == strlen(s.d));
+    Str padded = F("[%5d|%-3s|%.2f]", 42, "a", 1.5);
+    ASSERT(strcmp(padded.d, "[   42|a  |1.50]") == 0);
+    // Larger than chunk: formatted twice, still correct
+    Arena* small = ArenaCreate(128);
+    Str big = TapkiF(small, "%0300d|%s", 7, "end");
+    ASSERT(big.size == 304 && big.d[299] == '7' && strcmp(big.d + 300, "|end") == 0);
+    for (int i = 0; i < 100; ++i) {
+        TapkiStrAppendF(small, &big, "%03d,", i);
+    }
+    ASSERT(big.size == 704 && strcmp(big.d + big.size - 4, "099,") == 0);
+    ArenaFree(small);
+    // Arguments pointing into the target string itself
+    Str self = S("abc");
+    StrAppendF(&self, "x%s", self.d);
+    ASSERT(strcmp(self.d, "abcxabc") == 0);
+    StrAppendF(&self, "|%4.2s|%s", self.d + 4, self.d);
+    ASSERT(strcmp(self.d, "abcxabc|  ab|abcxabc") == 0 && self.size == strlen(self.d));
+    // Formatting at arena tail writes in place and claims only what was written
+    Arena* tight = ArenaCreate(4096);
+    Str tail = TapkiF(tight, "%5.1f", 2.25);
+    size_t used = ArenaStats(tight).in_use;
+    TapkiStrAppendF(tight, &tail, "%5.1f", 2.25);
+    ASSERT(ArenaStats(tight).in_use == used + 5 && tail.size == 10 && tail.cap == 11);
+    ASSERT(used == 6 && strcmp(tail.d, "  2.2  2.2") == 0);
+    ArenaFree(tight);
+    Str nums = {0};
+    StrAppendI64(&nums, INT64_MIN);
+    StrAppend(&nums, " ");
+    StrAppendU64(&nums, UINT64_MAX);
+    StrAppend(&nums, " ");
+    StrAppendI64(&nums, 0);
+    ASSERT(strcmp(nums.d, "-9223372036854775808 18446744073709551615 0") == 0);
+    double values[] = {0.1, 1.0 / 3, 1e300, -2.5e-310, 123456789012345680.0, 5, -0.0, 0.3, 1e15};
+    const char* expect[] = {"0.1", "0.3333333333333333", "1e+300", "-2.5e-310", "1.2345678901234568e+17", "5", "-0", "0.3", "1000000000000000"};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        Str d = {0};
+        StrAppendDouble(&d, values[i]);
+        ASSERT(strcmp(d.d, expect[i]) == 0 && strtod(d.d, NULL) == values[i]);
+    }
+}
+
+void Test_Parse(Arena* arena) {
+    int64_t i64 = 0;
+    ASSERT(ParseI64(SVOf("-9223372036854775808"), &i64) == TAPKI_PARSE_OK && i64 == INT64_MIN);
+    ASSERT(ParseI64(SVOf("9223372036854775807"), &i64) == TAPKI_PARSE_OK && i64 == INT64_MAX);
+    ASSERT(ParseI64(SVOf("9223372036854775808"), &i64) == TAPKI_PARSE_RANGE);
+    ASSERT(ParseI64(SVOf("+0000000000000000000000012"), &i64) == TAPKI_PARSE_OK && i64 == 12);
+    ASSERT(ParseI64(SVOf("12a"), &i64) == TAPKI_PARSE_INVALID && i64 == 12);
+    ASSERT(ParseI64(SVOf(""), &i64) == TAPKI_PARSE_EMPTY && ParseI64(SVOf("-"), &i64) == TAPKI_PARSE_EMPTY);
+    ASSERT(ParseI64(SVOf(" 1"), &i64) == TAPKI_PARSE_INVALID);
+    ASSERT(ParseI64(SV_Sub(SVOf("12345678901234567890"), 0, 17), &i64) == TAPKI_PARSE_OK && i64 == 12345678901234567);
+    uint64_t u64 = 0;
+    ASSERT(ParseU64(SVOf("18446744073709551615"), &u64) == TAPKI_PARSE_OK && u64 == UINT64_MAX);
+    ASSERT(ParseU64(SVOf("18446744073709551616"), &u64) == TAPKI_PARSE_RANGE);
+    ASSERT(ParseU64(SVOf("-1"), &u64) == TAPKI_PARSE_INVALID);
+    int32_t i32 = 0;
+    uint32_t u32 = 0;
+    ASSERT(ParseI32(SVOf("-2147483648"), &i32) == TAPKI_PARSE_OK && i32 == INT32_MIN);
+    ASSERT(ParseI32(SVOf("-2147483649"), &i32) == TAPKI_PARSE_RANGE);
+    ASSERT(ParseU32(SVOf("4294967295"), &u32) == TAPKI_PARSE_OK && u32 == UINT32_MAX);
+    ASSERT(ParseU32(SVOf("4294967296"), &u32) == TAPKI_PARSE_RANGE);
+    ASSERT(ToI32("-5") == -5 && ToU32("7") == 7 && ToI64("-1") == -1 && ToU64("1") == 1);
+    const char* floats[] = {"0", "-1.5", "3.14159", "1e10", "2.5E-3", ".5", "1.", "123456789.123456789",
+        "1e300", "4.9e-324", "0.1", "-0", "1234567890123456789012", "1.7976931348623157e308"};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); ++i) {
+        double d = -1;
+        ASSERT(ParseDouble(SVOf(floats[i]), &d) == TAPKI_PARSE_OK && d == strtod(floats[i], NULL));
+    }
+    double d = 0;
+    ASSERT(ParseDouble(SVOf("inf"), &d) == TAPKI_PARSE_OK && d > 1e308);
+    ASSERT(ParseDouble(SVOf("1e"), &d) == TAPKI_PARSE_INVALID && ParseDouble(SVOf("1.5x"), &d) == TAPKI_PARSE_INVALID);
+    ASSERT(ParseDouble(SVOf("1e400"), &d) == TAPKI_PARSE_RANGE && ToFloat("0.25") == 0.25);
+    // Slow path must not depend on decimal point of current locale
+    const char* commaLocales[] = {"de_DE.UTF-8", "ru_RU.UTF-8", "fr_FR.UTF-8", "de_DE", "ru_RU"};
+    for (size_t i = 0; i < sizeof(commaLocales) / sizeof(*commaLocales); ++i) {
+        if (!setlocale(LC_NUMERIC, commaLocales[i])) continue;
+        ASSERT(ParseDouble(SVOf("1.2345678901234567890123"), &d) == TAPKI_PARSE_OK && d > 1.2345 && d < 1.2346);
+        ASSERT(ParseDouble(SVOf("2.5e300"), &d) == TAPKI_PARSE_OK && d > 2.4e300 && d < 2.6e300);
+        ASSERT(ParseDouble(SVOf("2,5e300"), &d) == TAPKI_PARSE_INVALID);
+        setlocale(LC_NUMERIC, "C");
+        break;
+    }
+    IntVec nums = {0};
+    size_t bad = npos;
+    ASSERT(ParseI64Bulk(SVOf("1,-2,30000000000,4,"), ',', &nums, &bad) == TAPKI_PARSE_OK);
+    ASSERT(nums.size == 4 && nums.d[1] == -2 && nums.d[2] == 30000000000 && bad == npos);
+    ASSERT(ParseI64Bulk(SVOf("5\n6\n\n7"), '\n', &nums, &bad) == TAPKI_PARSE_EMPTY && bad == 4 && nums.size == 6);
+    ASSERT(ParseI64Bulk(SVOf("8,9x"), ',', &nums, &bad) == TAPKI_PARSE_INVALID && bad == 2);
+}
+
+void Test_Files(Arena* arena) {
+    const char* path = "tapki_test_file.tmp";
+    Str contents = {0};
+    for (int i = 0; i < 10000; ++i) {
+        StrAppendF(&contents, "line %d\n", i);
+    }
+    FileWrite(path, contents.d);
+    Str read = FileRead(path);
+    ASSERT(read.size == contents.size && strcmp(read.d, contents.d) == 0);
+    ArenaPos pos = ArenaMark(arena);
+    StrView mapped = FileMap(path, TAPKI_MAP_SEQUENTIAL);
+    ASSERT(SV_Eq(mapped, SV(contents)));
+    ASSERT(ArenaStats(arena).mapped == contents.size);
+    FileAdvise(SV_Sub(mapped, 100, 200), TAPKI_MAP_RANDOM);
+    ArenaRestore(arena, pos);
+    ASSERT(ArenaStats(arena).mapped == 0);
+    Reader* r = ReaderOpen(path);
+    StrView line;
+    int lines = 0;
+    while (ReaderNextLine(r, &line)) {
+        Str expected = F("line %d", lines);
+        ASSERT(SV_Eq(line, SV(expected)));
+        lines++;
+    }
+    ASSERT(lines == 10000 && !ReaderNextLine(r, &line));
+
+    Str longLine = {0};
+    while (longLine.size < 3 * TAPKI_READER_BUFFER) {
+        StrAppend(&longLine, "0123456789");
+    }
+    FileWrite(path, F("a\r\n\r\n%s\nlast", longLine.d).d);
+    r = ReaderOpen(path);
+    ASSERT(ReaderNextLine(r, &line) && SV_Eq(line, SVOf("a")));
+    ASSERT(ReaderNextLine(r, &line) && line.size == 0);
+    ASSERT(ReaderNextLine(r, &line) && SV_Eq(line, SV(longLine)));
+    ASSERT(ReaderNextLine(r, &line) && SV_Eq(line, SVOf("last")));
+    ASSERT(!ReaderNextLine(r, &line));
+
+    FileWrite(path, "x;y;;z;");
+    r = ReaderOpen(path);
+    StrView rec;
+    Str joined = {0};
+    while (ReaderNextRecord(r, ';', &rec)) {
+        StrAppendF(&joined, "[%.*s]", (int)rec.size, rec.d);
+    }
+    ASSERT(strcmp(joined.d, "[x][y][][z]") == 0);
+    r = ReaderOpen(path);
+    ASSERT(ReaderNextRecord(r, ';', &rec));
+    ReaderClose(r);
+    ASSERT(!ReaderNextRecord(r, ';', &rec));
+
+    Writer* w = WriterOpen(path, TAPKI_WRITE_TRUNCATE);
+    WriterAppend(w, "a\0b", 3);
+    WriterAppend(w, longLine.d, longLine.size);
+    Str parts[] = {S("x"), longLine, S(""), S("y")};
+    WriterAppendStrs(w, parts, 4);
+    WriterClose(w);
+    w = WriterOpen(path, TAPKI_WRITE_APPEND);
+    WriterAppendStrs(w, parts, 1);
+    WriterClose(w);
+    Str written = FileRead(path);
+    ASSERT(written.size == 3 + 2 * longLine.size + 3 && memcmp(written.d, "a\0b", 3) == 0);
+    ASSERT(SV_EndsWith(SV(written), SVOf("yx")));
+    w = WriterOpen(path, TAPKI_WRITE_ATOMIC);
+    WriterAppend(w, "new", 3);
+    WriterFlush(w);
+    ASSERT(FileRead(path).size == written.size);
+    WriterClose(w);
+    ASSERT(strcmp(FileRead(path).d, "new") == 0);
+
+    enum { FILES = 200 };
+    const char* paths[FILES];
+    for (int i = 0; i < FILES; ++i) {
+        paths[i] = F("tapki_test_many_%d.tmp", i).d;
+        Str data = S("");
+        for (int j = 0; j < i * i; ++j) {
+            StrAppendF(&data, "%d:%d\n", i, j);
+        }
+        FileWrite(paths[i], data.d);
+    }
+    StrVec many = FileReadMany(paths, FILES);
+    ASSERT(many.size == FILES);
+    for (int i = 0; i < FILES; ++i) {
+        Str expected = FileRead(paths[i]);
+        ASSERT(many.d[i].size == expected.size && strcmp(many.d[i].d, expected.d) == 0);
+        remove(paths[i]);
+    }
+    StrAppend(&many.d[FILES - 1], "tail");
+    ASSERT(StrEndsWith(many.d[FILES - 1].d, "\ntail"));
+    ASSERT(FileReadMany(paths, 0).size == 0);
+
+    FileWrite(path, "");
+    ASSERT(FileRead(path).size == 0);
+    ASSERT(FileMap(path, TAPKI_MAP_NORMAL).size == 0);
+    ASSERT(!ReaderNextLine(ReaderOpen(path), &line));
+    remove(path);
+}
+
+void Test_Frames(Arena* arena) {
+    const char* fmt = "%s %d/%5.2f [%-*s] %zu%% %c %lld %x %.3s|%hhd";
+    char expected[256];
+    snprintf(expected, sizeof(expected), fmt, "item", -3, 1.5, 4, "ab", (size_t)7, 'x', -9ll, 255u, "abcdef", 300);
+    Str name = S("item");
+    FrameF("%s %d/%5.2f [%-*s] %zu%% %c %lld %x %.3s|%hhd", name.d, -3, 1.5, 4, "ab", (size_t)7, 'x', -9ll, 255u, "abcdef", 300) {
+        Str line = F(" => %s\n", expected);
+        ASSERT(StrContains(Traceback().d, line.d));
+        // captured lazily: message shows strings as they are at Traceback time
+        name.d[0] = 'I';
+        ASSERT(StrContains(Traceback().d, " => Item "));
+    }
+    const char* manyFmt = "%d%d%d%d%d%d%d%d%d%d%d%d%d|%Lf";
+    snprintf(expected, sizeof(expected), manyFmt, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0.5L);
+    FrameF("%d%d%d%d%d%d%d%d%d%d%d%d%d|%Lf", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0.5L) {
+        Str line = F(" => %s\n", expected);
+        ASSERT(StrContains(Traceback().d, line.d));
+    }
+    const char* missing = name.size > 100 ? name.d : NULL;
+    FrameF("%s", missing) {
+        ASSERT(StrContains(Traceback().d, " => (null)\n"));
+    }
+    Frame() {
+        // only FrameF("Frames") from Test() has a message
+        Str trace = Traceback();
+        size_t arrows = 0;
+        for (const char* it = strstr(trace.d, " => "); it; it = strstr(it + 1, " => ")) {
+            arrows++;
+        }
+        ASSERT(arrows == 1 && StrContains(trace.d, " => Frames\n"));
+    }
+}
+
+static volatile uint64_t spin_sink;
+
+static void Spin(clock_t ticks) {
+    for (clock_t start = clock(); clock() - start < ticks;) {
+        for (int i = 0; i < 10000; ++i) {
+            spin_sink += i;
+        }
+    }
+}
+
+void Test_Profiler(Arena* arena) {
+#ifndef _WIN32
+    ProfilerReset();
+    ProfilerStart(1000);
+    FrameF("outer; %d", 1) {
+        FrameF("hot") {
+            Spin(CLOCKS_PER_SEC / 5);
+        }
+        Spin(CLOCKS_PER_SEC / 20);
+    }
+    ProfilerStop();
+    Str folded = ProfilerFolded();
+    ASSERT(StrContains(folded.d, "Test_Profiler (test.c:"));
+    const char* nested = ") outer, %d;Test_Profiler (test.c:";
+    ASSERT(StrContains(folded.d, nested));
+    ASSERT(StrContains(folded.d, ") hot "));
+    ProfilerReset();
+    ASSERT(ProfilerFolded().size == 0);
+    // Late SIGPROF after stop must not terminate the process
+    raise(SIGPROF);
+#endif
+}
+
+void Test_FrameTiming(Arena* arena) {
+    FrameTimingReset();
+    FrameTimingStart(true);
+    FrameF("outer \"zone\"") {
+        for (int i = 0; i < 100; ++i) {
+            FrameF("inner %d", i) {
+                spin_sink += i;
+            }
+        }
+    }
+    FrameTimingStop();
+    FrameF("after stop") {
+    }
+    Str report = FrameReport();
+    ASSERT(StrStartsWith(report.d, "   self ms"));
+    const char* inner = "        100 ";
+    ASSERT(StrContains(report.d, inner) && StrContains(report.d, ") inner "));
+    ASSERT(StrContains(report.d, ") outer \"zone\"\n"));
+    ASSERT(!StrContains(report.d, "after stop"));
+    Str json = FrameTraceJSON();
+    ASSERT(StrStartsWith(json.d, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    ASSERT(StrContains(json.d, "{\"name\":\"outer \\\"zone\\\"\",\"cat\":\"frame\",\"ph\":\"X\""));
+    size_t events = 0;
+    for (const char* it = strstr(json.d, "\"ph\":\"X\""); it; it = strstr(it + 1, "\"ph\":\"X\"")) {
+        events++;
+    }
+    ASSERT(events == 101);
+    FrameTimingReset();
+    ASSERT(!StrContains(FrameReport().d, "inner"));
+    // Scope open across reset is not exported with start before the new epoch
+    FrameTimingStart(true);
+    FrameF("across reset") {
+        FrameTimingReset();
+        FrameF("after reset") {
+        }
+    }
+    FrameTimingStop();
+    json = FrameTraceJSON();
+    ASSERT(StrContains(json.d, "\"after reset\"") && !StrContains(json.d, "across reset"));
+    FrameTimingReset();
+}
+
+void Test_ArenaScope() {
+    Arena* arena = ArenaCreate(256);
+    Str keep = S("keep");
+    ArenaPos pos = ArenaMark(arena);
+    char* first = ArenaAlloc(arena, 16);
+    for (int i = 0; i < 100; ++i) {
+        ArenaAlloc(arena, 100);
+    }
+    ArenaRestore(arena, pos);
+    ASSERT(ArenaAlloc(arena, 16) == first);
+    char* inner = NULL;
+    ArenaScope(arena) {
+        inner = ArenaAlloc(arena, 1000);
+    }
+    ASSERT(ArenaAlloc(arena, 1000) == inner);
+    ASSERT(strcmp(keep.d, "keep") == 0);
+    ArenaFree(arena);
+}
+
 void Test() {
     Frame() {
         Arena* arena = ArenaCreate(1024 * 20);
         FrameF("Maps") {
             Test_Maps(arena);
         }
+        FrameF("MapsBulk") {
+            Test_MapsBulk(arena);
+        }
+        FrameF("MapsFrozen") {
+            Test_MapsFrozen(arena);
+        }
+        FrameF("StrKeyMaps") {
+            Test_StrKeyMaps(arena);
+        }
+        FrameF("HashMaps") {
+            Test_HashMaps(arena);
+        }
+        FrameF("StrViews") {
+            Test_StrViews(arena);
+        }
+        FrameF("StrSearch") {
+            Test_StrSearch(arena);
+        }
+        FrameF("Matcher") {
+            Test_Matcher(arena);
+        }
+        FrameF("Format") {
+            Test_Format(arena);
+        }
+        FrameF("Parse") {
+            Test_Parse(arena);
+        }
+        FrameF("Files") {
+            Test_Files(arena);
+        }
+        FrameF("Frames") {
+            Test_Frames(arena);
+        }
+        FrameF("Profiler") {
+            Test_Profiler(arena);
+        }
+        FrameF("FrameTiming") {
+            Test_FrameTiming(arena);
+        }
+        FrameF("SmallStrings") {
+            Test_SmallStrings(arena);
+        }
+        FrameF("ArenaScope") {
+            Test_ArenaScope();
+        }
+        FrameF("ArenaStats") {
+            Test_ArenaStats();
+        }
+        FrameF("ArenaGrowth") {
+            Test_ArenaGrowth();
+        }
+        FrameF("ArenaRecycle") {
+            Test_ArenaRecycle();
+        }
+#ifndef _WIN32
+        FrameF("ArenaCacheThreadExit") {
+            Test_ArenaCacheThreadExit();
+        }
+#endif
+        FrameF("SharedArena") {
+            Test_SharedArena();
+        }
+#ifndef _WIN32
+        FrameF("SharedArenaThreads") {
+            Test_SharedArenaThreads();
+        }
+#endif
+        FrameF("ArenaLargeVec") {
+            Test_ArenaLargeVec();
+        }
         ArenaFree(arena);
     }
 }